@@ -0,0 +1,309 @@
+/**
+ * @file    BroadcastRing.cpp
+ *
+ * @brief   Implementation of class BroadcastRing
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include <cstring>
+
+#include "BroadcastRing.h"
+
+
+/**
+  * @brief  class constructor
+  *
+  * @param  size        ring size
+  *         maxReaders  reader cursors available to addReader()
+ */
+BroadcastRing::BroadcastRing( uint16_t size, uint8_t maxReaders ) :
+    _ByteArray( size ),
+    _cursors( new Cursor[maxReaders] ),
+    _maxReaders( maxReaders ),
+    _written( 0 ),
+    _gate( 0 ) {
+    for ( uint8_t i = 0; i < _maxReaders; ++i ) {
+        _cursors[i].position.store( 0, std::memory_order_relaxed );
+        _cursors[i].active.store( false, std::memory_order_relaxed );
+    }
+}
+
+
+/**
+  * @brief  class destructor
+  *
+  * @param  -
+ */
+BroadcastRing::~BroadcastRing( void ) {
+    delete[] _cursors;
+}
+
+
+/**
+ * @brief   returns size of the ring
+ *
+ * @param   -
+ *
+ * @return  ring size
+ */
+uint16_t
+BroadcastRing::size( void ) const {
+    return _ByteArray.size();
+}
+
+
+/**
+ * @brief   registers a reader, it sees bytes published from now on
+ *
+ * @param   -
+ *
+ * @return  reader id, -1 if all cursors are taken
+ */
+int8_t
+BroadcastRing::addReader( void ) {
+    if ( 0 == _ByteArray.size() ) {
+        return -1;
+    }
+    for ( uint8_t i = 0; i < _maxReaders; ++i ) {
+        bool expected = false;
+        if ( !_cursors[i].active.load( std::memory_order_relaxed ) &&
+             _cursors[i].active.compare_exchange_strong( expected, true,
+                std::memory_order_seq_cst ) ) {
+            //a writer that scanned before did not see it active and may run up
+            //to a ring past its gate, so the position is taken only now: the
+            //fence pairs with gate(), either the scan sees the cursor or this
+            //load sees everything written up to that scan
+            std::atomic_thread_fence( std::memory_order_seq_cst );
+            _cursors[i].position.store( _written.load( std::memory_order_relaxed ),
+                std::memory_order_release );
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * @brief   unregisters a reader, the writer stops waiting for it
+ *
+ * @param   reader  reader id
+ *
+ * @return  -
+ */
+void
+BroadcastRing::removeReader( uint8_t reader ) {
+    if ( reader < _maxReaders ) {
+        _cursors[reader].active.store( false, std::memory_order_release );
+    }
+}
+
+
+/**
+ * @brief   writer: free space, the reader cursors are rescanned only when
+ *          the cached slowest one leaves less than half of the ring
+ *
+ * @param   -
+ *
+ * @return  bytes that can be written
+ */
+uint16_t
+BroadcastRing::space( void ) {
+    uint64_t written = _written.load( std::memory_order_relaxed );
+    uint16_t free    = _ByteArray.size() - (uint16_t)( written - _gate );
+    if ( free < ( _ByteArray.size() >> 1 ) + 1 ) {
+        _gate = gate();
+        free  = _ByteArray.size() - (uint16_t)( written - _gate );
+    }
+    return free;
+}
+
+
+/**
+ * @brief   writer: copies in as many bytes as all readers leave room for
+ *
+ * @param   data    bytes to write
+ *          n       byte count
+ *
+ * @return  bytes written
+ */
+uint16_t
+BroadcastRing::put( const uint8_t* data, uint16_t n ) {
+    uint16_t written = 0;
+    while ( written < n ) {
+        uint16_t length;
+        uint8_t* target = claim( &length );
+        if ( 0 == length ) {
+            break;
+        }
+        if ( length > n - written ) {
+            length = n - written;
+        }
+        std::memcpy( target, data + written, length );
+        publish( length );
+        written += length;
+    }
+    return written;
+}
+
+
+/**
+ * @brief   writer: returns the contiguous free region for writing in place
+ *
+ * @param   pLength     region length, up to the end of the ring
+ *
+ * @return  pointer to the region
+ */
+uint8_t*
+BroadcastRing::claim( uint16_t* pLength ) {
+    uint16_t free   = space();
+    if ( 0 == free ) {
+        *pLength = 0;
+        return _ByteArray.data();
+    }
+    uint16_t offset = (uint16_t)( _written.load( std::memory_order_relaxed ) % _ByteArray.size() );
+    uint16_t run    = _ByteArray.size() - offset;
+    *pLength = ( run < free ) ? run : free;
+    return _ByteArray.data() + offset;
+}
+
+
+/**
+ * @brief   writer: makes n claimed bytes visible to all readers
+ *
+ * @param   n   byte count
+ *
+ * @return  -
+ */
+void
+BroadcastRing::publish( uint16_t n ) {
+    _written.store( _written.load( std::memory_order_relaxed ) + n, std::memory_order_release );
+}
+
+
+/**
+ * @brief   reader: bytes not yet consumed by the reader
+ *
+ * @param   reader  reader id
+ *
+ * @return  byte count
+ */
+uint16_t
+BroadcastRing::count( uint8_t reader ) const {
+    if ( reader >= _maxReaders ) {
+        return 0;
+    }
+    return (uint16_t)( _written.load( std::memory_order_acquire ) -
+                       _cursors[reader].position.load( std::memory_order_relaxed ) );
+}
+
+
+/**
+ * @brief   reader: returns the next contiguous batch in place
+ *
+ * @param   reader      reader id
+ *          pLength     batch length, up to the end of the ring
+ *
+ * @return  pointer to the batch
+ */
+const uint8_t*
+BroadcastRing::peek( uint8_t reader, uint16_t* pLength ) const {
+    if ( reader >= _maxReaders ) {
+        *pLength = 0;
+        return nullptr;
+    }
+    uint64_t position = _cursors[reader].position.load( std::memory_order_relaxed );
+    uint16_t filled   = (uint16_t)( _written.load( std::memory_order_acquire ) - position );
+    if ( 0 == filled ) {
+        *pLength = 0;
+        return _ByteArray.data();
+    }
+    uint16_t offset   = (uint16_t)( position % _ByteArray.size() );
+    uint16_t run      = _ByteArray.size() - offset;
+    *pLength = ( run < filled ) ? run : filled;
+    return _ByteArray.data() + offset;
+}
+
+
+/**
+ * @brief   reader: advances the cursor, releasing the bytes to the writer
+ *
+ * @param   reader  reader id
+ *          n       byte count
+ *
+ * @return  -
+ */
+void
+BroadcastRing::consume( uint8_t reader, uint16_t n ) {
+    if ( reader < _maxReaders ) {
+        uint16_t filled = count( reader );
+        if ( n > filled ) {
+            n = filled;
+        }
+        _cursors[reader].position.store(
+            _cursors[reader].position.load( std::memory_order_relaxed ) + n,
+            std::memory_order_release );
+    }
+}
+
+
+/**
+ * @brief   reader: copies out and consumes up to n bytes
+ *
+ * @param   reader  reader id
+ *          data    destination
+ *          n       max byte count
+ *
+ * @return  bytes copied
+ */
+uint16_t
+BroadcastRing::get( uint8_t reader, uint8_t* data, uint16_t n ) {
+    uint16_t copied = 0;
+    while ( copied < n ) {
+        uint16_t length;
+        const uint8_t* source = peek( reader, &length );
+        if ( 0 == length ) {
+            break;
+        }
+        if ( length > n - copied ) {
+            length = n - copied;
+        }
+        std::memcpy( data + copied, source, length );
+        consume( reader, length );
+        copied += length;
+    }
+    return copied;
+}
+
+
+/**
+ * @brief   returns the cursor of the slowest active reader,
+ *          everything is free when there are no readers
+ *
+ * @param   -
+ *
+ * @return  slowest reader position
+ */
+uint64_t
+BroadcastRing::gate( void ) const {
+    uint64_t written = _written.load( std::memory_order_relaxed );
+    uint64_t slowest = written;
+    std::atomic_thread_fence( std::memory_order_seq_cst );     //see addReader()
+    for ( uint8_t i = 0; i < _maxReaders; ++i ) {
+        if ( _cursors[i].active.load( std::memory_order_acquire ) ) {
+            uint64_t position = _cursors[i].position.load( std::memory_order_acquire );
+            if ( written - position > _ByteArray.size() ) {
+                position = written - _ByteArray.size();    //registering, not placed yet
+            }
+            if ( written - position > written - slowest ) {
+                slowest = position;
+            }
+        }
+    }
+    return slowest;
+}
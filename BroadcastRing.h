@@ -0,0 +1,81 @@
+/**
+ * @file    BroadcastRing.h
+ *
+ * @brief   Declaration of class BroadcastRing
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _BroadcastRing_H_
+#define _BroadcastRing_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "ByteArray.h"
+
+/**
+ * @brief   The BroadcastRing class is a single writer, multi reader byte ring:
+ *          every reader has its own cursor and sees every byte once, so one
+ *          write feeds a logger, a parser and a forwarder without copies.
+ *          The writer is gated only by the slowest active reader; readers get
+ *          contiguous batches in place with peek() and advance with consume().
+ *          One writer thread, each reader cursor used by one thread.
+ *          Totals are 64 bit, so offsets stay right for any size; a ring of
+ *          size 0 takes no readers and never has space.
+ */
+
+class BroadcastRing {
+    public:
+
+                        BroadcastRing( uint16_t size, uint8_t maxReaders = 4 );
+                       ~BroadcastRing( void );
+
+                        BroadcastRing( const BroadcastRing& other ) = delete;
+        BroadcastRing&  operator = ( const BroadcastRing& other ) = delete;
+
+        uint16_t        size( void ) const;
+
+        int8_t          addReader( void );
+        void            removeReader( uint8_t reader );
+
+        //writer
+        uint16_t        space( void );
+        uint16_t        put( const uint8_t* data, uint16_t n );
+        uint8_t*        claim( uint16_t* pLength );
+        void            publish( uint16_t n );
+
+        //readers
+        uint16_t        count( uint8_t reader ) const;
+        const uint8_t*  peek( uint8_t reader, uint16_t* pLength ) const;
+        void            consume( uint8_t reader, uint16_t n );
+        uint16_t        get( uint8_t reader, uint8_t* data, uint16_t n );
+
+    private:
+
+        //<! reader cursor, one per cache line
+        struct alignas( 64 ) Cursor {
+            std::atomic<uint64_t>   position;   //total bytes consumed, never wraps
+            std::atomic<bool>       active;
+        };
+
+        uint64_t        gate( void ) const;
+
+        //<! storage
+        ByteArray                   _ByteArray;
+        //<! cursors
+        Cursor*                     _cursors;
+        uint8_t                     _maxReaders;
+
+        //writer side
+        alignas( 64 )
+        std::atomic<uint64_t>       _written;   //total bytes published, never wraps
+        uint64_t                    _gate;      //slowest reader as last seen by the writer
+};
+
+#endif // _BroadcastRing_H_
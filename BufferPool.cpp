@@ -0,0 +1,152 @@
+/**
+ * @file    BufferPool.cpp
+ *
+ * @brief   Implementation of class BufferPool
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include <new>
+
+#include "BufferPool.h"
+
+
+/**
+  * @brief  class constructor, all buffers are allocated at once
+  *
+  * @param  bufferSize   bytes per buffer
+  *         bufferCount  buffers in the pool
+ */
+BufferPool::BufferPool( uint16_t bufferSize, uint16_t bufferCount ) :
+    _bufferSize( bufferSize ), _bufferCount( bufferCount ),
+    _storage( new uint8_t[(size_t)bufferSize * bufferCount] ),
+    _buffers( (ByteArray*)::operator new( sizeof( ByteArray ) * bufferCount ) ) {
+    _free.reserve( _bufferCount );
+    for ( uint16_t i = 0; i < _bufferCount; ++i ) {
+        new ( &_buffers[i] ) ByteArray( _bufferSize, 0, _storage + (size_t)i * _bufferSize, false );
+        _buffers[i].setOrigin( this );      //swap() keeps the storage in the pool
+    }
+    //first acquire() gets the first buffer
+    for ( uint16_t i = _bufferCount; i > 0; --i ) {
+        _free.push_back( &_buffers[i - 1] );
+    }
+}
+
+
+/**
+  * @brief  class destructor, buffers still out become invalid
+  *
+  * @param  -
+ */
+BufferPool::~BufferPool() {
+    for ( uint16_t i = 0; i < _bufferCount; ++i ) {
+        _buffers[i].~ByteArray();
+    }
+    ::operator delete( _buffers );
+    delete[] _storage;
+}
+
+
+/**
+ * @brief   takes an empty buffer from the free list
+ *
+ * @param   -
+ *
+ * @return  buffer, nullptr if the pool is exhausted
+ */
+ByteArray*
+BufferPool::acquire( void ) {
+    if ( _free.empty() ) {
+        return nullptr;
+    }
+    ByteArray* pByteArray = _free.back();
+    _free.pop_back();
+    return pByteArray;
+}
+
+
+/**
+ * @brief   returns a buffer to the free list, foreign buffers are ignored
+ *
+ * @param   pByteArray  buffer from acquire()
+ *
+ * @return  -
+ */
+void
+BufferPool::release( ByteArray* pByteArray ) {
+    if ( owns( pByteArray ) && ( _free.size() < _bufferCount ) ) {
+        pByteArray->clear();
+        _free.push_back( pByteArray );
+    }
+}
+
+
+/**
+ * @brief   returns flag indicating that the buffer comes from this pool
+ *
+ * @param   pByteArray  buffer
+ *
+ * @return  buffer is from the pool flag
+ */
+bool
+BufferPool::owns( const ByteArray* pByteArray ) const {
+    return ( _buffers <= pByteArray ) && ( pByteArray < _buffers + _bufferCount );
+}
+
+
+/**
+ * @brief   returns count of free buffers
+ *
+ * @param   -
+ *
+ * @return  free buffer count
+ */
+uint16_t
+BufferPool::available( void ) const {
+    return _free.size();
+}
+
+
+/**
+ * @brief   returns count of all buffers
+ *
+ * @param   -
+ *
+ * @return  buffer count
+ */
+uint16_t
+BufferPool::size( void ) const {
+    return _bufferCount;
+}
+
+
+/**
+ * @brief   returns size of every buffer
+ *
+ * @param   -
+ *
+ * @return  buffer size
+ */
+uint16_t
+BufferPool::bufferSize( void ) const {
+    return _bufferSize;
+}
+
+
+/**
+ * @brief   returns the one allocation all buffers are carved from,
+ *          buffer i starts at i * bufferSize(), e.g. to register it for I/O
+ *
+ * @param   -
+ *
+ * @return  storage of the pool
+ */
+uint8_t*
+BufferPool::storage( void ) const {
+    return _storage;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file    BufferPool.h
+ *
+ * @brief   Declaration of class BufferPool
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _BUFFERPOOL_H_
+#define _BUFFERPOOL_H_
+
+#include "ByteArray.h"
+
+#include <vector>
+
+
+/**
+ * @brief   The BufferPool class keeps bufferCount ByteArrays of bufferSize
+ *          bytes carved from one allocation and hands them out from a free
+ *          list. Buffers of one pool can be exchanged by ByteArray::swap /
+ *          Pipe::forward instead of copying, their storage never leaves
+ *          the pool, swapping with any other buffer is refused. A buffer
+ *          is an edge of a Pipeline built with AddBuffer( pPool ) for the
+ *          lifetime of that Pipeline, only its storage moves along the
+ *          chain; drained buffers are not handed back while it runs, the
+ *          Pipeline destructor returns them here instead of deleting them.
+ */
+
+class BufferPool {
+
+public:
+    BufferPool( uint16_t bufferSize, uint16_t bufferCount );
+    ~BufferPool();
+
+    BufferPool( const BufferPool& other ) = delete;
+    BufferPool& operator = ( const BufferPool& other ) = delete;
+
+    ByteArray*  acquire( void );                    //nullptr if all are taken
+    void        release( ByteArray* pByteArray );   //empties it
+
+    bool        owns( const ByteArray* pByteArray ) const;
+    uint16_t    available( void ) const;
+    uint16_t    size( void ) const;
+    uint16_t    bufferSize( void ) const;
+    uint8_t*    storage( void ) const;              //all buffers, size() * bufferSize() bytes
+
+private:
+    uint16_t                _bufferSize;
+    uint16_t                _bufferCount;
+    uint8_t*                _storage;
+    ByteArray*              _buffers;               //_bufferCount, placement constructed
+    std::vector<ByteArray*> _free;
+};
+
+#endif // _BUFFERPOOL_H_
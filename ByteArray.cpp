@@ -61,6 +61,19 @@ ByteArray::ByteArray( uint16_t size, uint16_t filled, uint8_t* dataptr ) :
 }
 
 
+/**
+  * @brief  class constructor, all parameters and ownership of the buffer
+  *
+  * @param  size  buffer size
+  *         filled  useful data bytes count
+  *         dataptr  pointer to buffer
+  *         owned  false: the buffer is not deleted by the destructor
+ */
+ByteArray::ByteArray( uint16_t size, uint16_t filled, uint8_t* dataptr, bool owned ) :
+    _size( size ), _count( filled ), _data( dataptr ), _owned( owned ) {
+}
+
+
 /**
   * @brief  class constructor, initialised repeating a char
   *
@@ -69,8 +82,7 @@ ByteArray::ByteArray( uint16_t size, uint16_t filled, uint8_t* dataptr ) :
  */
 ByteArray::ByteArray( uint16_t repeats, char c ) :
     _size( repeats ), _count( repeats ), _data( new uint8_t[repeats] ) {
-    //std::memset( _data, c, (size_t)repeats);  //?
-    std::memset( const_cast<uint8_t*>( _data ), c, (size_t)repeats );
+    std::memset( _data, c, (size_t)repeats );
 }
 
 
@@ -107,6 +119,7 @@ ByteArray::ByteArray( const ByteArray& other ) :
     _count( other._count ),
     _data( new uint8_t[other._count] ) {
     std::memcpy( _data, other._data, _count );
+    _linear = other._linear;                //a copy of a ring is a ring, not its storage origin
 }
 
 
@@ -118,11 +131,13 @@ ByteArray::ByteArray( const ByteArray& other ) :
 ByteArray::ByteArray( ByteArray&& other ) noexcept :
     _size( other._size ),
     _count( other._count ),
-    _data( other._data ) {
+    _data( other._data ),
+    _owned( other._owned ),
+    _origin( other._origin ) {
     //overtake aByteArray._data, overtake aByteArray._size
+    _linear = other._linear;
     //invalidate
-    //aByteArray._data  = nullptr;    //*const
-    const_cast<uint8_t*&>( other._data ) = nullptr; //const_cast
+    other._data  = nullptr;
     other._size  = 0;
     other._count = 0;
 }
@@ -134,7 +149,9 @@ ByteArray::ByteArray( ByteArray&& other ) noexcept :
   * @param  -
  */
 ByteArray::~ByteArray( void ) {
-    delete[] _data;
+    if ( _owned ) {
+        delete[] _data;
+    }
 }
 
 
@@ -225,6 +242,70 @@ ByteArray::clear( void ) {
     _count = 0;
 }
 
+/**
+ * @brief   exchanges storage, size and count with other in O(1),
+ *          so a buffer is handed over without copying it,
+ *          only if canSwap( other )
+ *
+ * @param   other   ByteArray to exchange with
+ *
+ * @return  false if refused, nothing exchanged
+ */
+bool
+ByteArray::swap( ByteArray& other ) {
+    if ( !canSwap( other ) ) {
+        return false;
+    }
+    std::swap( _data,  other._data );
+    std::swap( _count, other._count );
+    return true;
+}
+
+
+/**
+ * @brief   returns flag indicating that swap() may exchange the storage:
+ *          both linear, of the same size, ownership and origin, so a pool
+ *          buffer keeps pool storage and a ring keeps its _head and _tail
+ *
+ * @param   other   ByteArray to exchange with
+ *
+ * @return  swap allowed flag
+ */
+bool
+ByteArray::canSwap( const ByteArray& other ) const {
+    return _linear && other._linear
+        && ( _size == other._size ) && ( _owned == other._owned ) && ( _origin == other._origin );
+}
+
+
+/**
+ * @brief   tags the storage with where it comes from, e.g. the
+ *          BufferPool, storage never leaves its origin by swap()
+ *
+ * @param   origin  owner of the storage, nullptr for none
+ *
+ * @return  -
+ */
+void
+ByteArray::setOrigin( const void* origin ) {
+    _origin = origin;
+}
+
+
+/**
+ * @brief   returns flag indicating that data() holds count() bytes
+ *          from its start, false for a ring laid out by CircularBuffer
+ *
+ * @param   -
+ *
+ * @return  linear flag
+ */
+bool
+ByteArray::isLinear( void ) const {
+    return _linear;
+}
+
+
 /**
  * @brief   extends the content to the _size
  *
@@ -317,6 +398,28 @@ ByteArray::append( int repeats, uint8_t abyte ) {
 }
 
 
+/**
+ * @brief   appends size bytes with one memcpy, as many as fit
+ *
+ * @param   data    bytes to append
+ *          size    byte count
+ *
+ * @return  appended byte count
+ */
+uint16_t
+ByteArray::append( const uint8_t* data, uint16_t size ) {
+    if ( !_data || !data ) {
+        return 0;
+    }
+    if ( size > _size - _count ) {
+        size = _size - _count;
+    }
+    memcpy( _data + _count, data, size );
+    _count += size;
+    return size;
+}
+
+
 /**
  * @brief   return byte at x*width+y
  *
@@ -56,6 +56,16 @@ class ByteArray {
           */
                     ByteArray( uint16_t size, uint16_t filled, uint8_t* dataptr );
 
+        /**
+          * @brief  class constructor, all parameters and ownership of the buffer
+          *
+          * @param  size  buffer size
+          *         filled  useful data bytes count
+          *         dataptr  pointer to buffer
+          *         owned  false: the buffer is not deleted by the destructor
+          */
+                    ByteArray( uint16_t size, uint16_t filled, uint8_t* dataptr, bool owned );
+
         /**
           * @brief  class constructor, initialised repeating a char
           *
@@ -150,6 +160,47 @@ class ByteArray {
          */
         void        clear( void );
 
+        /**
+         * @brief   exchanges storage, size and count with other in O(1),
+         *          so a buffer is handed over without copying it,
+         *          only if canSwap( other )
+         *
+         * @param   other   ByteArray to exchange with
+         *
+         * @return  false if refused, nothing exchanged
+         */
+        bool        swap( ByteArray& other );
+
+        /**
+         * @brief   returns flag indicating that swap() may exchange the storage:
+         *          both linear, of the same size, ownership and origin
+         *
+         * @param   other   ByteArray to exchange with
+         *
+         * @return  swap allowed flag
+         */
+        bool        canSwap( const ByteArray& other ) const;
+
+        /**
+         * @brief   tags the storage with where it comes from, e.g. the
+         *          BufferPool, storage never leaves its origin by swap()
+         *
+         * @param   origin  owner of the storage, nullptr for none
+         *
+         * @return  -
+         */
+        void        setOrigin( const void* origin );
+
+        /**
+         * @brief   returns flag indicating that data() holds count() bytes
+         *          from its start, false for a ring laid out by CircularBuffer
+         *
+         * @param   -
+         *
+         * @return  linear flag
+         */
+        bool        isLinear( void ) const;
+
         /**
          * @brief   extends the content to the _size
          *
@@ -230,6 +281,16 @@ class ByteArray {
          */
         ByteArray   append( int repeats, uint8_t abyte );
 
+        /**
+         * @brief   appends size bytes with one memcpy, as many as fit
+         *
+         * @param   data    bytes to append
+         *          size    byte count
+         *
+         * @return  appended byte count
+         */
+        uint16_t    append( const uint8_t* data, uint16_t size );
+
         /**
          * @brief   return ByteArray converted form HEX
          *
@@ -295,13 +356,21 @@ class ByteArray {
          */
         void        print2Dd( int width, int height ) const;
 
+    protected:
+        //<! false: a derived class lays out _data, e.g. as a ring
+        bool            _linear = true;
+
     private:
         //<! size
         uint16_t        _size;
         //<! count
         uint16_t        _count;
         //<! data
-        uint8_t* const  _data;
+        uint8_t*        _data;
+        //<! _data is deleted by the destructor
+        bool            _owned  = true;
+        //<! owner of _data if not this, see setOrigin()
+        const void*     _origin = nullptr;
 };
 
 #endif // _ByteArray_H_
@@ -0,0 +1,84 @@
+/**
+ * @file    CallablePipe.h
+ *
+ * @brief   Declaration of class CallablePipe
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _CALLABLEPIPE_H_
+#define _CALLABLEPIPE_H_
+
+#include "Pipe.h"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+//bytes reserved in every CallablePipe for the callable,
+//a bigger one does not compile
+#ifndef CALLABLE_PIPE_SIZE
+#define CALLABLE_PIPE_SIZE 48
+#endif
+
+
+/*
+ * CallablePipe is a Pipe whose processor is any callable, typically a
+ * lambda with captures, stored inline in the pipe:
+ *
+ *  pipeline.AddProcessor( new CallablePipe( in,
+ *      [&connection]( ByteArray* pIn, ByteArray* pOut ) { ... }, out ) );
+ *
+ * The callable is copied into CALLABLE_PIPE_SIZE bytes inside the object, no
+ * heap is used. It is called through the ProcessorCtxFunc of Pipe with the
+ * storage as context, so process() costs exactly what a context processor
+ * costs.
+ */
+
+class CallablePipe : public Pipe {
+
+    public:
+
+        template < typename F >
+        CallablePipe( ByteArray* pInput_data, F&& callable, ByteArray* pOutput_data = nullptr ) :
+            Pipe( pInput_data, &invoke<typename std::decay<F>::type>, _storage, pOutput_data ),
+            _destroy( &destroy<typename std::decay<F>::type> ) {
+            using Callable = typename std::decay<F>::type;
+            static_assert( sizeof( Callable ) <= CALLABLE_PIPE_SIZE,
+                "callable too big for CallablePipe, raise CALLABLE_PIPE_SIZE" );
+            static_assert( alignof( Callable ) <= alignof( std::max_align_t ),
+                "callable alignment not supported by CallablePipe" );
+            new ( _storage ) Callable( std::forward<F>( callable ) );
+        }
+
+        ~CallablePipe() {
+            _destroy( _storage );
+        }
+
+        CallablePipe( const CallablePipe& ) = delete;
+        CallablePipe& operator = ( const CallablePipe& ) = delete;
+
+    private:
+
+        template < typename Callable >
+        static StatusCode invoke( ByteArray* pInput_data, ByteArray* pOutput_data, void* context ) {
+            return ( *(Callable*)context )( pInput_data, pOutput_data );
+        }
+
+        template < typename Callable >
+        static void destroy( void* context ) {
+            ( (Callable*)context )->~Callable();
+        }
+
+        void                                    ( *_destroy )( void* );
+        alignas( std::max_align_t ) uint8_t     _storage[CALLABLE_PIPE_SIZE];
+};
+
+#endif // _CALLABLEPIPE_H_
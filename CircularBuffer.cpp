@@ -23,6 +23,7 @@
 
 CircularBuffer::CircularBuffer( uint16_t size ) :
     ByteArray( size ), _head( 0 ), _tail( 0 ) {
+    _linear = false;                        //_head and _tail lay out the storage
 }
 
         /**
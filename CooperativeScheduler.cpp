@@ -0,0 +1,256 @@
+/**
+ * @file    CooperativeScheduler.cpp
+ *
+ * @brief   Implementation of the CooperativeScheduler class
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include "CooperativeScheduler.h"
+
+
+CooperativeScheduler::CooperativeScheduler( uint64_t slice ) :
+    _slice( slice ? slice : COOPERATIVE_SLICE ) {
+}
+
+
+/* Setup */
+
+int16_t CooperativeScheduler::AddPipeline( Pipeline* pPipeline, uint64_t slice ) {
+    if ( !pPipeline || _entries.size() >= 0x7FFF ) {
+        return -1;
+    }
+    Entry entry = { pPipeline, slice ? slice : _slice, StatusCode::PENDING, {},
+                    0, true, false, 0, 0, UINT64_MAX, 0, {} };      //notified: gets a first look
+    _entries.push_back( entry );
+    return _entries.size() - 1;
+}
+
+void CooperativeScheduler::setSlice( uint16_t id, uint64_t slice ) {
+    if ( id < _entries.size() ) {
+        _entries[id].slice = slice ? slice : _slice;
+    }
+}
+
+void CooperativeScheduler::setClock( uint64_t (*now)( void ) ) {
+    _now = now ? now : pipelineNow;
+}
+
+void CooperativeScheduler::setMode( Mode mode ) {
+    _mode = mode;
+}
+
+void CooperativeScheduler::setDeadline( uint16_t id, uint8_t priority, uint64_t deadline ) {
+    if ( id < _entries.size() ) {
+        _entries[id].priority = priority;
+        _entries[id].deadline = deadline;
+    }
+}
+
+void CooperativeScheduler::notify( uint16_t id ) {
+    if ( id < _entries.size() ) {
+        _entries[id].notified = true;
+        release( _entries[id], _now() );        //the deadline runs from the arrival
+    }
+}
+
+
+/* Scheduling */
+
+//OK and REPEAT leave the pipeline mid way, NEXT finished a pass and
+//another one makes sense only with data at the front end
+bool CooperativeScheduler::hasMore( const Entry& entry ) const {
+    switch ( entry.lastStatus ) {
+    case StatusCode::OK:
+    case StatusCode::REPEAT:
+        return true;
+
+    case StatusCode::NEXT: {
+        ByteArray* frontEnd = entry.pipeline->getFrontEnd();
+        return !frontEnd || frontEnd->count();      //a source makes its own data
+    }
+
+    default:                            //PENDING, PARTIAL, ERROR
+        return false;
+    }
+}
+
+//More to do, or input that came since the last turn
+bool CooperativeScheduler::hasWork( const Entry& entry ) const {
+    if ( entry.notified || hasMore( entry ) ) {
+        return true;
+    }
+    ByteArray* frontEnd = entry.pipeline->getFrontEnd();
+    return frontEnd && frontEnd->count() && ( frontEnd->count() != entry.frontCount );
+}
+
+//Priority, then earliest deadline, then longest waiting
+bool CooperativeScheduler::urgent( const Entry& a, const Entry& b ) const {
+    if ( a.priority != b.priority ) {
+        return a.priority > b.priority;
+    }
+    if ( a.due != b.due ) {
+        return a.due < b.due;
+    }
+    return a.served < b.served;
+}
+
+//A burst of work starts, its deadline runs from now
+void CooperativeScheduler::release( Entry& entry, uint64_t now ) {
+    if ( !entry.released ) {
+        entry.released = true;
+        entry.due      = entry.deadline ? now + entry.deadline : UINT64_MAX;
+    }
+}
+
+//The burst is done, slack or lateness against its deadline
+void CooperativeScheduler::finish( Entry& entry ) {
+    entry.released = false;
+    if ( !entry.deadline ) {
+        return;
+    }
+    uint64_t now = _now();
+    ++entry.stats.jobs;
+    if ( now <= entry.due ) {
+        entry.slack.record( entry.due - now );
+    } else {
+        ++entry.stats.misses;
+        if ( now - entry.due > entry.stats.worstLateness ) {
+            entry.stats.worstLateness = now - entry.due;
+        }
+    }
+    entry.due = UINT64_MAX;
+}
+
+//One slice of a pipeline, true if it still has work when the slice ends.
+//Another call is made only while one as long as the last still fits.
+bool CooperativeScheduler::turn( Entry& entry ) {
+    uint64_t start = _now();
+    uint64_t now   = start;
+    uint64_t call;
+    ++entry.stats.slices;
+    do {
+        call = now;
+        entry.lastStatus = entry.pipeline->processAll();
+        ++entry.stats.calls;
+        now  = _now();
+        call = now - call;
+    } while ( ( now - start + call <= entry.slice ) && hasMore( entry ) );
+
+    uint64_t used = now - start;
+    entry.stats.time += used;
+    _total           += used;
+    if ( used > entry.slice ) {
+        ++entry.stats.overruns;
+        if ( used - entry.slice > entry.stats.worstOverrun ) {
+            entry.stats.worstOverrun = used - entry.slice;
+        }
+    }
+    return hasMore( entry );
+}
+
+//A turn with the bookkeeping of bursts around it
+bool CooperativeScheduler::serve( Entry& entry ) {
+    entry.notified = false;
+    entry.served   = ++_sequence;
+    bool more = turn( entry );
+    ByteArray* frontEnd = entry.pipeline->getFrontEnd();
+    entry.frontCount = frontEnd ? frontEnd->count() : 0;
+    if ( entry.released && !hasWork( entry ) ) {
+        finish( entry );
+    }
+    return more;
+}
+
+//ROUND_ROBIN: a slice for every pipeline, DEADLINE: as many steps
+StatusCode CooperativeScheduler::runOnce( void ) {
+    bool more = false;
+    if ( DEADLINE == _mode ) {
+        for ( size_t k = 0; k < _entries.size(); ++k ) {
+            if ( StatusCode::OK != step() ) {
+                return StatusCode::PENDING;
+            }
+        }
+        for ( auto& entry : _entries ) {
+            more |= hasWork( entry );
+        }
+        return more ? StatusCode::OK : StatusCode::PENDING;
+    }
+
+    uint64_t now = _now();
+    for ( auto& entry : _entries ) {
+        if ( hasWork( entry ) ) {
+            release( entry, now );
+        }
+        more |= serve( entry );
+    }
+    return more ? StatusCode::OK : StatusCode::PENDING;
+}
+
+StatusCode CooperativeScheduler::step( void ) {
+    uint64_t now  = _now();
+    Entry*   next = nullptr;
+    for ( auto& entry : _entries ) {
+        if ( !hasWork( entry ) ) {
+            continue;
+        }
+        release( entry, now );
+        if ( !next || urgent( entry, *next ) ) {
+            next = &entry;
+        }
+    }
+    if ( !next ) {
+        return StatusCode::PENDING;
+    }
+    serve( *next );
+    return StatusCode::OK;
+}
+
+
+/* Statistics */
+
+uint16_t CooperativeScheduler::getPipelineCount( void ) const {
+    return _entries.size();
+}
+
+StatusCode CooperativeScheduler::getLastStatus( uint16_t id ) const {
+    if ( id < _entries.size() ) {
+        return _entries[id].lastStatus;
+    }
+    return StatusCode::ERROR;
+}
+
+bool CooperativeScheduler::getStats( uint16_t id, SliceStats* pStats ) const {
+    if ( !pStats || id >= _entries.size() ) {
+        return false;
+    }
+    *pStats = _entries[id].stats;
+    return true;
+}
+
+double CooperativeScheduler::getShare( uint16_t id ) const {
+    if ( id >= _entries.size() || !_total ) {
+        return 0.0;
+    }
+    return (double)_entries[id].stats.time / _total;
+}
+
+const LatencyHistogram* CooperativeScheduler::getSlack( uint16_t id ) const {
+    if ( id < _entries.size() ) {
+        return &_entries[id].slack;
+    }
+    return nullptr;
+}
+
+void CooperativeScheduler::resetStats( void ) {
+    for ( auto& entry : _entries ) {
+        entry.stats = {};
+        entry.slack.clear();
+    }
+    _total = 0;
+}
@@ -0,0 +1,129 @@
+/**
+ * @file    CooperativeScheduler.h
+ *
+ * @brief   Declaration of CooperativeScheduler
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _COOPERATIVESCHEDULER_H_
+#define _COOPERATIVESCHEDULER_H_
+
+
+//time slice of a pipeline, in clock units (ns with the default clock)
+#ifndef COOPERATIVE_SLICE
+#define COOPERATIVE_SLICE 100000
+#endif
+
+
+#include "Pipeline.h"
+
+#include <vector>
+
+
+//what CooperativeScheduler counts per pipeline, in clock units
+struct SliceStats {
+    uint64_t    slices;                 //turns the pipeline got
+    uint64_t    calls;                  //processAll() calls
+    uint64_t    time;                   //spent in processAll()
+    uint64_t    overruns;               //slices that ended past their budget
+    uint64_t    worstOverrun;           //longest time past the budget
+    uint64_t    jobs;                   //bursts of work finished, with a deadline
+    uint64_t    misses;                 //of them finished past the deadline
+    uint64_t    worstLateness;          //longest time past a deadline
+};
+
+
+/*
+ * CooperativeScheduler shares one thread between Pipelines, round robin.
+ * Every pipeline gets a time slice per round and processAll() is called
+ * again while the pipeline has more to do and another call as long as the
+ * last one fits into the slice. More to do is OK and REPEAT (processAll()
+ * resumes at its _pipeOffset by itself), or NEXT while the front end still
+ * holds data; PENDING and errors end the turn early. Nothing is preempted,
+ * so a slice always allows one call and a slice that still ends past its
+ * budget, a call slower than the one before, is counted as an overrun.
+ * A busy pipeline thus costs the others at most its slice plus one call.
+ *
+ * The clock is pipelineNow() by default, setClock() takes any monotonic
+ * counter (a cycle counter, a timer tick), slices are in its units.
+ *
+ * In DEADLINE mode step() runs one slice of the most urgent pipeline with
+ * work: the highest priority first, the earliest deadline (EDF) among equal
+ * priorities, the longest waiting among equal deadlines. A burst of work is
+ * released by notify(), or else when the scheduler first sees it (data at
+ * the front end, more to do), and is due its relative deadline later; 0 means no
+ * deadline, such pipelines come after the ones with a deadline. A burst is
+ * finished when the pipeline has nothing left to do; the slack it had left
+ * goes into a histogram, finishing late counts a miss. A control pipeline
+ * then waits at most one slice of a bulk one, however busy that is.
+ * A PENDING pipeline is looked at again only when its front end count
+ * changes or notify() is called.
+ */
+
+class CooperativeScheduler {
+
+public:
+    enum Mode : uint8_t {
+        ROUND_ROBIN,    //runOnce(): a slice for every pipeline in turn
+        DEADLINE        //step(): a slice for the most urgent pipeline
+    };
+
+    CooperativeScheduler( uint64_t slice = COOPERATIVE_SLICE );
+
+    int16_t    AddPipeline( Pipeline* pPipeline, uint64_t slice = 0 );     //id, -1 on error; 0: default slice
+    void       setSlice( uint16_t id, uint64_t slice );
+    void       setClock( uint64_t (*now)( void ) );
+    void       setMode( Mode mode );
+    void       setDeadline( uint16_t id, uint8_t priority, uint64_t deadline );   //higher priority first, 0: no deadline
+
+    void       notify( uint16_t id );                       //input the front end does not show
+    StatusCode runOnce( void );                             //one round, OK: more to do, PENDING: idle
+    StatusCode step( void );                                //one slice, OK: ran one, PENDING: idle
+
+    uint16_t   getPipelineCount( void ) const;
+    StatusCode getLastStatus( uint16_t id ) const;
+    bool       getStats( uint16_t id, SliceStats* pStats ) const;
+    double     getShare( uint16_t id ) const;               //of the time spent in all pipelines, 0..1
+    const LatencyHistogram* getSlack( uint16_t id ) const;  //time left at finished bursts
+    void       resetStats( void );
+
+private:
+
+    struct Entry {
+        Pipeline*           pipeline;
+        uint64_t            slice;
+        StatusCode          lastStatus;
+        SliceStats          stats;
+        uint8_t             priority;
+        bool                notified;
+        bool                released;       //a burst is open
+        uint16_t            frontCount;     //front end count after the last turn
+        uint64_t            deadline;       //relative, 0: none
+        uint64_t            due;            //absolute, of the open burst
+        uint64_t            served;         //sequence number of the last turn
+        LatencyHistogram    slack;
+    };
+
+    bool       hasMore( const Entry& entry ) const;
+    bool       hasWork( const Entry& entry ) const;
+    bool       urgent( const Entry& a, const Entry& b ) const;
+    void       release( Entry& entry, uint64_t now );
+    void       finish( Entry& entry );
+    bool       turn( Entry& entry );
+    bool       serve( Entry& entry );
+
+    uint64_t                _slice;
+    uint64_t              (*_now)( void )   = pipelineNow;
+    uint64_t                _total          = 0;        //time of all pipelines
+    uint64_t                _sequence       = 0;
+    Mode                    _mode           = ROUND_ROBIN;
+    std::vector<Entry>      _entries;
+};
+
+#endif // _COOPERATIVESCHEDULER_H_
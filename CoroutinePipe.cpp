@@ -0,0 +1,166 @@
+/**
+ * @file    CoroutinePipe.cpp
+ *
+ * @brief   Implementation of the CoroutinePipe class
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+
+#include "CoroutinePipe.h"
+
+#if defined( __cpp_impl_coroutine )
+
+#include <new>
+
+
+//every frame starts with its owner, nullptr for heap frames
+#define FRAME_HEADER alignof( std::max_align_t )
+
+
+/* Task */
+
+CoroutinePipe::Task CoroutinePipe::Task::promise_type::get_return_object( void ) {
+    return Task( std::coroutine_handle<promise_type>::from_promise( *this ) );
+}
+
+CoroutinePipe::Task::~Task() {
+    if ( _handle ) {
+        _handle.destroy();
+    }
+}
+
+
+/* CoroutinePipe */
+
+//Constructor with a free coroutine function
+CoroutinePipe::CoroutinePipe( ByteArray* pInput_data, CoroutineFunc coroutine, ByteArray* pOutput_data )
+    : Pipe( pInput_data, (ProcessorFunc)nullptr, pOutput_data ), _coroutine( coroutine ) {}
+
+//Constructor for derived classes overriding run()
+CoroutinePipe::CoroutinePipe( ByteArray* pInput_data, ByteArray* pOutput_data )
+    : Pipe( pInput_data, (ProcessorFunc)nullptr, pOutput_data ) {}
+
+//Destructor, the frame may still be suspended
+CoroutinePipe::~CoroutinePipe() {
+    reset();
+}
+
+//Default body of derived classes that do not override run()
+CoroutinePipe::Task CoroutinePipe::run( void ) {
+    co_return StatusCode::ERROR;
+}
+
+//Resume the coroutine if what it waits for is there
+StatusCode CoroutinePipe::process() {
+
+    if ( !_handle ) {
+        //start over, the frame goes to the arena
+        Task task = _coroutine ? _coroutine( *this ) : run();
+        _handle      = task._handle;
+        task._handle = nullptr;
+        _waitKind    = WAIT_NONE;
+    }
+
+    switch ( _waitKind ) {
+    case WAIT_INPUT:
+        if ( !isSatisfied( _waitKind, _waitCount ) ) {
+            return StatusCode::PENDING;
+        }
+        break;
+    case WAIT_SPACE:
+        if ( !isSatisfied( _waitKind, _waitCount ) ) {
+            return StatusCode::OK;      //let the next pipes drain the output
+        }
+        break;
+    default:
+        break;
+    }
+
+    _waitKind = WAIT_NONE;
+    _handle.resume();
+
+    if ( _handle.done() ) {
+        StatusCode status = _handle.promise().status;
+        reset();
+        return status;
+    }
+
+    switch ( _waitKind ) {
+    case WAIT_INPUT:
+        return StatusCode::PENDING;
+    case WAIT_SPACE:
+        return StatusCode::OK;
+    default:                            //co_yield
+        return _handle.promise().status;
+    }
+}
+
+//Destroy the suspended frame, the next process() starts the coroutine again
+void CoroutinePipe::reset( void ) {
+    if ( _handle ) {
+        _handle.destroy();
+        _handle = nullptr;
+    }
+    _waitKind  = WAIT_NONE;
+    _waitCount = 0;
+}
+
+
+/* Awaitables */
+
+CoroutinePipe::Wait CoroutinePipe::input( uint16_t n ) {
+    return { this, WAIT_INPUT, n };
+}
+
+CoroutinePipe::Wait CoroutinePipe::space( uint16_t n ) {
+    return { this, WAIT_SPACE, n };
+}
+
+bool CoroutinePipe::isSatisfied( uint8_t kind, uint16_t n ) const {
+    switch ( kind ) {
+    case WAIT_INPUT:
+        return _pInput_data && ( _pInput_data->count() >= n );
+    case WAIT_SPACE:
+        return _pOutput_data && ( _pOutput_data->size() - _pOutput_data->count() >= n );
+    default:
+        return true;
+    }
+}
+
+
+/* Frame memory */
+
+//Arena of this pipe if it is free and big enough
+void* CoroutinePipe::allocateFrame( std::size_t size ) {
+    if ( !_arenaUsed && ( FRAME_HEADER + size <= COROUTINE_FRAME_SIZE ) ) {
+        _arenaUsed = true;
+        *(CoroutinePipe**)_arena = this;
+        return _arena + FRAME_HEADER;
+    }
+    return allocateFrame( nullptr, size );
+}
+
+//Heap frame
+void* CoroutinePipe::allocateFrame( CoroutinePipe* pOwner, std::size_t size ) {
+    uint8_t* block = (uint8_t*)::operator new( FRAME_HEADER + size );
+    *(CoroutinePipe**)block = pOwner;
+    return block + FRAME_HEADER;
+}
+
+void CoroutinePipe::freeFrame( void* frame ) {
+    uint8_t*       block  = (uint8_t*)frame - FRAME_HEADER;
+    CoroutinePipe* pOwner = *(CoroutinePipe**)block;
+    if ( pOwner ) {
+        pOwner->_arenaUsed = false;
+    } else {
+        ::operator delete( block );
+    }
+}
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,156 @@
+/**
+ * @file    CoroutinePipe.h
+ *
+ * @brief   Declaration of class CoroutinePipe
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _COROUTINEPIPE_H_
+#define _COROUTINEPIPE_H_
+
+#include "Pipe.h"
+
+//needs C++20, e.g. -std=c++20
+#if defined( __cpp_impl_coroutine )
+
+#include <coroutine>
+#include <cstddef>
+
+
+//bytes reserved in every CoroutinePipe for the coroutine frame,
+//a bigger frame falls back to the heap
+#ifndef COROUTINE_FRAME_SIZE
+#define COROUTINE_FRAME_SIZE 512
+#endif
+
+
+/*
+ * CoroutinePipe is a Pipe whose processor is a coroutine, so a parser keeps
+ * its state in local variables instead of a hand made state machine:
+ *
+ *  CoroutinePipe::Task parser( CoroutinePipe& pipe ) {
+ *      co_await pipe.input( 2 );               //PENDING until 2 bytes are in
+ *      ...
+ *      co_await pipe.space( n );               //OK until downstream drained
+ *      ...
+ *      co_return StatusCode::NEXT;             //done, next process() starts over
+ *  }
+ *
+ *  pipeline.AddProcessor( new CoroutinePipe( in, parser, out ) );
+ *
+ * process() resumes the coroutine exactly where it stopped. While it waits,
+ * process() only checks the condition and does not resume it. co_yield a
+ * StatusCode hands that status to processAll() and continues from there on
+ * the next call. The frame is created when the coroutine starts and lives in
+ * the pipe itself (COROUTINE_FRAME_SIZE), so resuming never allocates and a
+ * restart after co_return reuses the same memory. The pipe must be the only
+ * parameter of the coroutine for that, or the coroutine a member function of
+ * a class derived from CoroutinePipe without parameters.
+ */
+
+class CoroutinePipe : public Pipe {
+
+    public:
+
+        class Task {
+            public:
+                struct promise_type {
+                    StatusCode  status = StatusCode::NEXT;  //co_yield / co_return
+
+                    Task                get_return_object( void );
+                    std::suspend_always initial_suspend( void ) noexcept { return {}; }
+                    std::suspend_always final_suspend( void ) noexcept { return {}; }
+                    std::suspend_always yield_value( StatusCode value ) { status = value; return {}; }
+                    void                return_value( StatusCode value ) { status = value; }
+                    void                unhandled_exception( void ) { status = StatusCode::ERROR; }
+
+                    //frame in the pipe's arena, not a template, so that it pairs
+                    //with operator delete
+                    static void* operator new( std::size_t size, CoroutinePipe& pipe ) {
+                        return pipe.allocateFrame( size );
+                    }
+                    //anything else, e.g. a coroutine with more parameters
+                    static void* operator new( std::size_t size ) {
+                        return CoroutinePipe::allocateFrame( nullptr, size );
+                    }
+                    static void  operator delete( void* frame ) {
+                        CoroutinePipe::freeFrame( frame );
+                    }
+                };
+
+                Task( std::coroutine_handle<promise_type> handle ) : _handle( handle ) {}
+                Task( Task&& other ) noexcept : _handle( other._handle ) { other._handle = nullptr; }
+                Task( const Task& ) = delete;
+                ~Task();
+
+            private:
+                friend class CoroutinePipe;
+                std::coroutine_handle<promise_type> _handle;
+        };
+
+        using CoroutineFunc = Task (*)( CoroutinePipe& );
+
+        CoroutinePipe(
+            ByteArray* pInput_data,
+            CoroutineFunc coroutine,
+            ByteArray* pOutput_data = nullptr
+        );
+        ~CoroutinePipe();
+
+        CoroutinePipe( const CoroutinePipe& ) = delete;
+        CoroutinePipe& operator = ( const CoroutinePipe& ) = delete;
+
+        StatusCode process() override;
+
+        void       reset( void );                       //drop the frame, start over
+
+        //awaitables for the coroutine body
+        struct Wait {
+            CoroutinePipe*  pipe;
+            uint8_t         kind;
+            uint16_t        n;
+
+            bool await_ready( void ) const { return pipe->isSatisfied( kind, n ); }
+            void await_suspend( std::coroutine_handle<> ) { pipe->_waitKind = kind; pipe->_waitCount = n; }
+            void await_resume( void ) const {}
+        };
+
+        Wait       input( uint16_t n = 1 );             //at least n bytes in the input
+        Wait       space( uint16_t n = 1 );             //at least n bytes free in the output
+
+    protected:
+
+        //for derived classes whose coroutine is a member function
+        CoroutinePipe( ByteArray* pInput_data, ByteArray* pOutput_data );
+        virtual Task run( void );
+
+    private:
+
+        enum WaitKind : uint8_t {
+            WAIT_NONE,
+            WAIT_INPUT,
+            WAIT_SPACE
+        };
+
+        bool         isSatisfied( uint8_t kind, uint16_t n ) const;
+        void*        allocateFrame( std::size_t size );
+        static void* allocateFrame( CoroutinePipe* pOwner, std::size_t size );
+        static void  freeFrame( void* frame );
+
+        CoroutineFunc                                   _coroutine  = nullptr;
+        std::coroutine_handle<Task::promise_type>       _handle     = nullptr;
+        uint8_t                                         _waitKind   = WAIT_NONE;
+        uint16_t                                        _waitCount  = 0;
+        bool                                            _arenaUsed  = false;
+        alignas( std::max_align_t ) uint8_t             _arena[COROUTINE_FRAME_SIZE];
+};
+
+#endif // __cpp_impl_coroutine
+
+#endif // _COROUTINEPIPE_H_
@@ -17,6 +17,7 @@
 #include <stdio.h>
 #include "Dictionary.h"
 #include <cstring>
+#include <cctype>
 
 static char snBuffer[20];
 
@@ -702,6 +703,59 @@ void        Dictionary::clear( void ) {
     _keys = 0;
 }
 
+/**
+ * @brief   appends the records of a text in the print() format:
+ *          lines of key : data, # starts a comment to the end of the line
+ *
+ * @param   text        the text to parse
+ * @param   pErrorLine  if not nullptr, set to the line that failed, counted from 1
+ *
+ * @return  true if every line parsed, false at a line without a key,
+ *          a repeated key or a full dictionary
+ */
+bool
+Dictionary::parse( const char* text, uint16_t* pErrorLine ) {
+    std::string akey;
+    std::string adata;
+    uint16_t    line = 0;
+
+    while ( text && *text ) {
+        line++;
+        const char* end = strchr( text, '\n' );
+        if ( !end ) end = text + strlen( text );
+        const char* hash = (const char*)memchr( text, '#', end - text );
+        const char* stop = hash ? hash : end;
+        const char* colon = (const char*)memchr( text, ':', stop - text );
+
+        //trim the key and the data of spaces, tabs and \r
+        const char* k0 = text;
+        const char* k1 = colon ? colon : stop;
+        while ( k0 < k1 && isspace( (uint8_t)*k0 ) ) k0++;
+        while ( k1 > k0 && isspace( (uint8_t)k1[-1] ) ) k1--;
+
+        if ( k0 < k1 || colon ) {
+            //not an empty or comment line
+            if ( !colon || k0 == k1 ) goto failed;
+            const char* d0 = colon + 1;
+            const char* d1 = stop;
+            while ( d0 < d1 && isspace( (uint8_t)*d0 ) ) d0++;
+            while ( d1 > d0 && isspace( (uint8_t)d1[-1] ) ) d1--;
+            akey.assign( k0, k1 - k0 );
+            adata.assign( d0, d1 - d0 );
+            if ( contains( akey.c_str() ) ) goto failed;
+            //key, 0, data, 0
+            if ( (size_t)( _ByteArray.size() - _ByteArray.count() ) < ( akey.size() + adata.size() + 2 ) ) goto failed;
+            append( akey.c_str(), adata.c_str() );
+        }
+        text = *end ? end + 1 : end;
+    }
+    return true;
+
+failed:
+    if ( pErrorLine ) *pErrorLine = line;
+    return false;
+}
+
 /**
  * @brief   prints the dictionary in an elegant way
  *
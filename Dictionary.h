@@ -266,6 +266,18 @@ class Dictionary {
          */
         void        clear( void );
 
+        /**
+         * @brief   appends the records of a text in the print() format:
+         *          lines of key : data, # starts a comment to the end of the line
+         *
+         * @param   text        the text to parse
+         * @param   pErrorLine  if not nullptr, set to the line that failed, counted from 1
+         *
+         * @return  true if every line parsed, false at a line without a key,
+         *          a repeated key or a full dictionary
+         */
+        bool        parse( const char* text, uint16_t* pErrorLine = nullptr );
+
         /**
          * @brief   prints the dictionary in an elegant way
          *
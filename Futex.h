@@ -0,0 +1,78 @@
+/**
+ * @file    Futex.h
+ *
+ * @brief   Thin wrappers around the Linux futex and eventfd syscalls
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _Futex_H_
+#define _Futex_H_
+
+#if defined( __linux__ )
+
+#include <stdint.h>
+#include <atomic>
+#include <climits>
+#include <ctime>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+/**
+ * @brief   sleeps while *word == expected, at most timeoutMs (-1 waits forever)
+ *
+ * @param   word        futex word
+ *          expected    value the caller saw before going to sleep
+ *          timeoutMs   relative timeout in ms, -1 means no timeout
+ *
+ * @return  0 when woken, -1 on timeout, EAGAIN or EINTR (see errno)
+ */
+inline int futexWait( std::atomic<uint32_t>* word, uint32_t expected, int32_t timeoutMs ) {
+    struct timespec ts;
+    struct timespec* pts = nullptr;
+    if ( 0 <= timeoutMs ) {
+        ts.tv_sec  = timeoutMs / 1000;
+        ts.tv_nsec = ( timeoutMs % 1000 ) * 1000000L;
+        pts = &ts;
+    }
+    return (int)syscall( SYS_futex, reinterpret_cast<uint32_t*>( word ),
+        FUTEX_WAIT_PRIVATE, expected, pts, nullptr, 0 );
+}
+
+/**
+ * @brief   wakes up to count sleepers of word
+ *
+ * @param   word    futex word
+ *          count   sleepers to wake, INT_MAX wakes all
+ *
+ * @return  number of woken sleepers
+ */
+inline int futexWake( std::atomic<uint32_t>* word, int count = INT_MAX ) {
+    return (int)syscall( SYS_futex, reinterpret_cast<uint32_t*>( word ),
+        FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0 );
+}
+
+/**
+ * @brief   CLOCK_MONOTONIC time in ms, used to turn timeouts into deadlines
+ *
+ * @param   -
+ *
+ * @return  monotonic time in ms
+ */
+inline int64_t monotonicMs( void ) {
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000L;
+}
+
+#endif // __linux__
+
+#endif // _Futex_H_
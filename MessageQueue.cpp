@@ -0,0 +1,247 @@
+/**
+ * @file    MessageQueue.cpp
+ *
+ * @brief   Implementation of class MessageQueue
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include <cstring>
+
+#include "MessageQueue.h"
+
+
+/**
+  * @brief  class constructor
+  *
+  * @param  size  ring size in bytes, length prefixes included
+ */
+MessageQueue::MessageQueue( uint16_t size ) :
+    _ByteArray( size ), _write( 0 ), _read( 0 ) {
+}
+
+
+/**
+ * @brief   returns size of the ring
+ *
+ * @param   -
+ *
+ * @return  ring size in bytes
+ */
+uint16_t
+MessageQueue::size( void ) const {
+    return _ByteArray.size();
+}
+
+
+/**
+ * @brief   returns the largest payload that always fits into the empty queue,
+ *          wherever the read position stands, so half of the ring
+ *
+ * @param   -
+ *
+ * @return  max message length
+ */
+uint16_t
+MessageQueue::maxMessage( void ) const {
+    uint16_t half = _ByteArray.size() >> 1;
+    return ( half > HEADER_SIZE ) ? half - HEADER_SIZE - 1 : 0;
+}
+
+
+/**
+ * @brief   returns flag indicating that there are no committed messages
+ *
+ * @param   -
+ *
+ * @return  queue is empty flag
+ */
+bool
+MessageQueue::isEmpty( void ) const {
+    return _read.load( std::memory_order_acquire ) == _write.load( std::memory_order_acquire );
+}
+
+
+/**
+ * @brief   producer: reserves contiguous space for a message of length bytes
+ *
+ * @param   length  payload length
+ *
+ * @return  pointer to the payload space, nullptr if it does not fit now
+ */
+uint8_t*
+MessageQueue::reserve( uint16_t length ) {
+    if ( length > maxMessage() ) {
+        return nullptr;
+    }
+    uint16_t need  = HEADER_SIZE + length;
+    uint16_t write = _write.load( std::memory_order_relaxed );
+    uint16_t read  = _read.load( std::memory_order_acquire );
+    uint16_t pos;
+    bool     wrap  = false;
+
+    //write may never catch up with read, equal means empty
+    if ( write >= read ) {
+        uint16_t tailroom = _ByteArray.size() - write;
+        if ( ( need < tailroom ) || ( ( need == tailroom ) && ( 0 != read ) ) ) {
+            pos = write;
+        } else if ( need < read ) {
+            pos  = 0;
+            wrap = true;
+        } else {
+            return nullptr;
+        }
+    } else if ( need < read - write ) {
+        pos = write;
+    } else {
+        return nullptr;
+    }
+
+    _reservePos    = pos;
+    _reserveLength = length;
+    _reserveWrap   = wrap;
+    return _ByteArray.data() + pos + HEADER_SIZE;
+}
+
+
+/**
+ * @brief   producer: publishes the reserved message
+ *
+ * @param   length  actual payload length, not more than reserved
+ *
+ * @return  -
+ */
+void
+MessageQueue::commit( uint16_t length ) {
+    if ( length > _reserveLength ) {
+        length = _reserveLength;
+    }
+    writeHeader( _reservePos, length );
+    if ( _reserveWrap ) {
+        //less than a header left at the end means wrap without a marker
+        uint16_t write = _write.load( std::memory_order_relaxed );
+        if ( _ByteArray.size() - write >= HEADER_SIZE ) {
+            writeHeader( write, WRAP_MARKER );
+        }
+    }
+    uint16_t write = _reservePos + HEADER_SIZE + length;
+    if ( write >= _ByteArray.size() ) {
+        write = 0;
+    }
+    _reserveLength = 0;
+    _reserveWrap   = false;
+    _write.store( write, std::memory_order_release );
+}
+
+
+/**
+ * @brief   consumer: returns the oldest message in place, does not remove it
+ *
+ * @param   pLength     message length
+ *
+ * @return  pointer to the payload, nullptr if the queue is empty
+ */
+const uint8_t*
+MessageQueue::peek( uint16_t* pLength ) {
+    uint16_t read  = _read.load( std::memory_order_relaxed );
+    uint16_t write = _write.load( std::memory_order_acquire );
+    if ( read == write ) {
+        _peeked = false;
+        return nullptr;
+    }
+    if ( ( _ByteArray.size() - read < HEADER_SIZE ) || ( WRAP_MARKER == readHeader( read ) ) ) {
+        read = 0;
+    }
+    _peekPos    = read;
+    _peekLength = readHeader( read );
+    _peeked     = true;
+    if ( pLength ) {
+        *pLength = _peekLength;
+    }
+    return _ByteArray.data() + read + HEADER_SIZE;
+}
+
+
+/**
+ * @brief   consumer: removes the oldest message
+ *
+ * @param   -
+ *
+ * @return  -
+ */
+void
+MessageQueue::release( void ) {
+    if ( !_peeked && !peek( nullptr ) ) {
+        return;
+    }
+    uint16_t read = _peekPos + HEADER_SIZE + _peekLength;
+    if ( read >= _ByteArray.size() ) {
+        read = 0;
+    }
+    _peeked = false;
+    _read.store( read, std::memory_order_release );
+}
+
+
+/**
+ * @brief   producer: copies a message in and commits it
+ *
+ * @param   data    payload
+ *          length  payload length
+ *
+ * @return  false if the message does not fit now
+ */
+bool
+MessageQueue::put( const uint8_t* data, uint16_t length ) {
+    uint8_t* payload = reserve( length );
+    if ( !payload ) {
+        return false;
+    }
+    std::memcpy( payload, data, length );
+    commit( length );
+    return true;
+}
+
+
+/**
+ * @brief   consumer: copies the oldest message out and removes it,
+ *          a message longer than maxLength is truncated
+ *
+ * @param   data        destination
+ *          maxLength   destination size
+ *
+ * @return  message length, 0 if the queue is empty
+ */
+uint16_t
+MessageQueue::get( uint8_t* data, uint16_t maxLength ) {
+    uint16_t length;
+    const uint8_t* payload = peek( &length );
+    if ( !payload ) {
+        return 0;
+    }
+    std::memcpy( data, payload, ( length < maxLength ) ? length : maxLength );
+    release();
+    return length;
+}
+
+
+/**
+ * @brief   drops all messages, not to be called while the other side is active
+ *
+ * @param   -
+ *
+ * @return  -
+ */
+void
+MessageQueue::clear( void ) {
+    _reserveLength = 0;
+    _reserveWrap   = false;
+    _peeked        = false;
+    _read.store( 0, std::memory_order_relaxed );
+    _write.store( 0, std::memory_order_release );
+}
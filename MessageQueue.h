@@ -0,0 +1,92 @@
+/**
+ * @file    MessageQueue.h
+ *
+ * @brief   Declaration of class MessageQueue
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _MessageQueue_H_
+#define _MessageQueue_H_
+
+#include <stdint.h>
+#include <atomic>
+
+#include "ByteArray.h"
+
+/**
+ * @brief   The MessageQueue class is a record oriented ring of length prefixed
+ *          messages (U16 length as putU16 writes it, then the payload).
+ *          A message is always stored contiguously: when it does not fit before
+ *          the end of the ring, a wrap marker is left and it goes to the start.
+ *          Producer: reserve() -> fill in place -> commit().
+ *          Consumer: peek() -> read in place -> release().
+ *          A message is visible to the consumer only after commit(), so it is
+ *          never seen split or half written. Safe for one producer and one
+ *          consumer thread.
+ */
+
+class MessageQueue {
+    public:
+
+                        MessageQueue( uint16_t size );
+
+                        MessageQueue( const MessageQueue& other ) = delete;
+        MessageQueue&   operator = ( const MessageQueue& other ) = delete;
+
+        uint16_t        size( void ) const;
+        uint16_t        maxMessage( void ) const;
+        bool            isEmpty( void ) const;
+
+        uint8_t*        reserve( uint16_t length );
+        void            commit(  uint16_t length );
+
+        const uint8_t*  peek(    uint16_t* pLength );
+        void            release( void );
+
+        bool            put( const uint8_t* data, uint16_t length );
+        uint16_t        get( uint8_t* data, uint16_t maxLength );
+
+        void            clear( void );
+
+    private:
+
+        //<! wrap marker left in place of a length that does not fit before the end
+        static const uint16_t       WRAP_MARKER = 0xFFFF;
+        //<! length prefix size
+        static const uint16_t       HEADER_SIZE = 2;
+
+        inline uint16_t readHeader( uint16_t pos ) const {
+            return (uint16_t)_ByteArray.data()[pos] |
+                 ( (uint16_t)_ByteArray.data()[pos + 1] << 8 );
+        }
+
+        inline void     writeHeader( uint16_t pos, uint16_t length ) {
+            _ByteArray.data()[pos]     = (uint8_t)length;
+            _ByteArray.data()[pos + 1] = (uint8_t)( length >> 8 );
+        }
+
+        //<! storage
+        ByteArray                   _ByteArray;
+
+        //producer side
+        alignas( 64 )
+        std::atomic<uint16_t>       _write;
+        uint16_t                    _reservePos     = 0;
+        uint16_t                    _reserveLength  = 0;
+        bool                        _reserveWrap    = false;
+
+        //consumer side
+        alignas( 64 )
+        std::atomic<uint16_t>       _read;
+        uint16_t                    _peekPos        = 0;
+        uint16_t                    _peekLength     = 0;
+        bool                        _peeked         = false;
+};
+
+#endif // _MessageQueue_H_
@@ -0,0 +1,247 @@
+/**
+ * @file    ParallelPipe.cpp
+ *
+ * @brief   Implementation of the ParallelPipe class
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include "ParallelPipe.h"
+
+#if defined( __linux__ )
+
+#include "Futex.h"
+
+#include <cstring>
+
+
+//Constructor with chunks of a fixed size
+ParallelPipe::ParallelPipe( ByteArray* pInput_data, ProcessorFunc processor, ByteArray* pOutput_data,
+                            uint16_t chunkSize, uint8_t threads )
+    : Pipe( pInput_data, processor, pOutput_data ), _chunkSize( chunkSize ? chunkSize : 1 ) {
+    start( threads );
+}
+
+//Constructor with frames told by framer
+ParallelPipe::ParallelPipe( ByteArray* pInput_data, ProcessorFunc processor, ByteArray* pOutput_data,
+                            FrameFunc framer, uint8_t threads )
+    : Pipe( pInput_data, processor, pOutput_data ), _framer( framer ) {
+    start( threads );
+}
+
+//Destructor, wakes the workers up to let them go
+ParallelPipe::~ParallelPipe() {
+    _running.store( false, std::memory_order_release );
+    _generation.fetch_add( 1, std::memory_order_acq_rel );
+    futexWake( &_generation );
+    for ( auto& worker : _workers ) {
+        worker.join();
+    }
+    for ( auto output : _outputs ) {
+        delete output;
+    }
+}
+
+//The calling thread is one of threads
+void ParallelPipe::start( uint8_t threads ) {
+    if ( !threads ) {
+        unsigned cores = std::thread::hardware_concurrency();
+        threads = ( !cores ) ? 1 : ( ( 255 < cores ) ? 255 : cores );
+    }
+    _views.reserve( PARALLEL_MAX_CHUNKS );
+    _outputs.reserve( PARALLEL_MAX_CHUNKS );
+    _status.resize( PARALLEL_MAX_CHUNKS );
+    _ticket.store( 0 );
+    _count.store( 0 );
+    _finished.store( 0 );
+    _generation.store( 0 );
+    _running.store( true );
+    for ( uint8_t i = 1; i < threads; ++i ) {
+        _workers.push_back( std::thread( &ParallelPipe::run, this ) );
+    }
+}
+
+
+/* Chunks */
+
+//Views of the whole chunks or frames at the front of the input
+uint16_t ParallelPipe::split( void ) {
+    _views.clear();
+    uint8_t* data  = _pInput_data->data();
+    uint16_t count = _pInput_data->count();
+    uint16_t offset = 0;
+    while ( offset < count && _views.size() < PARALLEL_MAX_CHUNKS ) {
+        uint16_t length;
+        if ( _framer ) {
+            length = _framer( data + offset, count - offset );
+            if ( !length || length > count - offset ) {
+                break;                          //not a whole frame yet
+            }
+        } else {
+            length = ( count - offset < _chunkSize ) ? count - offset : _chunkSize;
+        }
+        _views.emplace_back( length, length, data + offset, false );
+        offset += length;
+    }
+    return _views.size();
+}
+
+//Runs the processor on a chunk into its own output buffer
+void ParallelPipe::runChunk( uint32_t k ) {
+    _outputs[k]->clear();
+#if EXCEPTIONS_SUPPORTED
+    try {
+        _status[k] = _processor( &_views[k], _outputs[k] );
+    } catch (...) {
+        _status[k] = StatusCode::ERROR;
+    }
+#else
+    _status[k] = _processor( &_views[k], _outputs[k] );
+#endif
+}
+
+//Takes chunks of the call generation until there are none left
+void ParallelPipe::work( uint32_t generation ) {
+    uint64_t ticket = _ticket.load( std::memory_order_acquire );
+    while ( ( (uint32_t)( ticket >> 32 ) == generation )
+         && ( (uint32_t)ticket < _count.load( std::memory_order_relaxed ) ) ) {
+        if ( _ticket.compare_exchange_weak( ticket, ticket + 1, std::memory_order_acq_rel ) ) {
+            runChunk( (uint32_t)ticket );
+            if ( _finished.fetch_add( 1, std::memory_order_acq_rel ) + 1
+                 == _count.load( std::memory_order_relaxed ) ) {
+                futexWake( &_finished );
+            }
+            ticket = _ticket.load( std::memory_order_acquire );
+        }
+    }
+}
+
+//Worker thread, sleeps until the next call
+void ParallelPipe::run( void ) {
+    uint32_t seen = 0;
+    while ( _running.load( std::memory_order_acquire ) ) {
+        uint32_t generation = _generation.load( std::memory_order_acquire );
+        if ( generation == seen ) {
+            futexWait( &_generation, generation, -1 );
+            continue;
+        }
+        seen = generation;
+        work( generation );
+    }
+}
+
+//Appends the pending outputs in order, false if the output is full first
+bool ParallelPipe::flush( void ) {
+    for ( ; _pendingFirst < _pendingLast; ++_pendingFirst, _sent = 0 ) {
+        ByteArray* chunk = _outputs[_pendingFirst];
+        _sent += _pOutput_data->append( chunk->data() + _sent, chunk->count() - _sent );
+        if ( _sent < chunk->count() ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/* Processing */
+
+StatusCode ParallelPipe::process() {
+    if ( !flush() ) {
+        return StatusCode::OK;                  //the pipes after it drain the output first
+    }
+    uint16_t count = split();
+    if ( !count ) {
+        return StatusCode::PENDING;
+    }
+    while ( _outputs.size() < count ) {
+        _outputs.push_back( new ByteArray( _pOutput_data->size() ) );
+    }
+    for ( uint16_t k = 0; k < count; ++k ) {
+        if ( _outputs[k]->size() < _pOutput_data->size() ) {
+            delete _outputs[k];
+            _outputs[k] = new ByteArray( _pOutput_data->size() );
+        }
+    }
+
+    if ( _workers.empty() || 1 == count ) {
+        for ( uint16_t k = 0; k < count; ++k ) {
+            runChunk( k );
+        }
+    } else {
+        //publish the chunks, then the ticket of the new generation
+        uint32_t generation = _generation.load( std::memory_order_relaxed ) + 1;
+        _count.store( count, std::memory_order_relaxed );
+        _finished.store( 0, std::memory_order_relaxed );
+        _ticket.store( (uint64_t)generation << 32, std::memory_order_release );
+        _generation.store( generation, std::memory_order_release );
+        futexWake( &_generation );
+        work( generation );
+        uint32_t finished;
+        while ( count != ( finished = _finished.load( std::memory_order_acquire ) ) ) {
+            futexWait( &_finished, finished, -1 );
+        }
+    }
+    _chunks += count;
+
+    //what the chunks took, only the last one may leave a rest
+    StatusCode status = StatusCode::NEXT;
+    uint16_t   end    = 0;                      //of the chunks in the input
+    uint16_t   last   = 0;                      //offset of the last chunk
+    uint16_t   keep   = 0;                      //its rest, moved to its front
+    uint16_t   ready  = 0;                      //chunks with an output to append
+    for ( uint16_t k = 0; k < count; ++k ) {
+        last  = end;
+        end  += _views[k].size();
+    }
+    for ( ; ready < count; ++ready ) {
+        if ( StatusCode::ERROR == _status[ready] || StatusCode::PARTIAL == _status[ready]
+          || ( _views[ready].count() && ( ready + 1 < count ) ) ) {
+            status = StatusCode::ERROR;         //this chunk and the ones after are dropped
+            break;
+        }
+    }
+    if ( StatusCode::ERROR != status ) {
+        keep = _views[count - 1].count();
+    }
+
+    //the rest of the last chunk and the bytes after the chunks to the front
+    uint8_t* data = _pInput_data->data();
+    uint16_t tail = _pInput_data->count() - end;
+    if ( end != keep ) {
+        memmove( data, data + last, keep );
+        memmove( data + keep, data + end, tail );
+        _pInput_data->update_count( keep + tail );
+    }
+
+    _pendingFirst = 0;
+    _pendingLast  = ready;
+    _sent         = 0;
+    if ( !flush() && StatusCode::ERROR != status ) {
+        return StatusCode::OK;                  //the pipes after it drain the output first
+    }
+    if ( end == keep ) {
+        return StatusCode::PENDING;             //one chunk, the processor needs more of it
+    }
+    if ( StatusCode::NEXT == status && PARALLEL_MAX_CHUNKS == count && tail ) {
+        return StatusCode::REPEAT;              //split() stopped at the cap, chunks are left
+    }
+    return status;
+}
+
+
+/* Getters */
+
+uint8_t ParallelPipe::getThreadCount( void ) const {
+    return _workers.size() + 1;
+}
+
+uint64_t ParallelPipe::getChunkCount( void ) const {
+    return _chunks;
+}
+
+#endif // __linux__
@@ -0,0 +1,121 @@
+/**
+ * @file    ParallelPipe.h
+ *
+ * @brief   Declaration of class ParallelPipe
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _PARALLELPIPE_H_
+#define _PARALLELPIPE_H_
+
+#if defined( __linux__ )
+
+
+//chunks one process() call hands out at most, each keeps an output buffer
+#ifndef PARALLEL_MAX_CHUNKS
+#define PARALLEL_MAX_CHUNKS 64
+#endif
+
+
+#include "Pipe.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/*
+ * ParallelPipe runs a stateless processor (hex decode, checksums,
+ * transcoding) on many chunks of its input at once:
+ *
+ *  pipeline.AddProcessor( new ParallelPipe( in, hexDecode, out, 512 ) );
+ *
+ * process() splits the input into chunks of a fixed size, or into frames
+ * told by a FrameFunc, and the processor gets every chunk as its own input
+ * with its own output buffer, on the worker threads and the calling thread.
+ * The outputs are appended to the output in input order, so the result is
+ * the same whatever thread ran which chunk.
+ *
+ * The processor must consume a chunk completely, only the last one may be
+ * left partly unconsumed (moved to the front as usual), that rest stays in
+ * the input for the next call, as do bytes not making a whole frame.
+ * What does not fit the output waits in the chunk buffers and goes out
+ * before new chunks are taken, process() returns OK meanwhile. Input past
+ * PARALLEL_MAX_CHUNKS chunks is left for the next call, REPEAT says so. An ERROR
+ * (or PARTIAL) from a chunk drops that chunk and the ones after it.
+ *
+ * The worker threads sleep on a futex between calls. Only one thread may
+ * call process() at a time, as with any Pipe.
+ */
+
+class ParallelPipe : public Pipe {
+
+    public:
+
+        //length of the first whole frame at data, 0 if it is not complete yet
+        using FrameFunc = uint16_t (*)( const uint8_t* data, uint16_t count );
+
+        ParallelPipe(
+            ByteArray* pInput_data,
+            ProcessorFunc processor,
+            ByteArray* pOutput_data,
+            uint16_t chunkSize,
+            uint8_t threads = 0                 //calling thread included, 0: one per core
+        );
+        ParallelPipe(
+            ByteArray* pInput_data,
+            ProcessorFunc processor,
+            ByteArray* pOutput_data,
+            FrameFunc framer,
+            uint8_t threads = 0
+        );
+        ~ParallelPipe();
+
+        ParallelPipe( const ParallelPipe& ) = delete;
+        ParallelPipe& operator = ( const ParallelPipe& ) = delete;
+
+        StatusCode process() override;
+
+        uint8_t    getThreadCount( void ) const;
+        uint64_t   getChunkCount( void ) const;         //chunks processed
+
+    private:
+
+        void       start( uint8_t threads );
+        uint16_t   split( void );
+        void       runChunk( uint32_t k );
+        void       work( uint32_t generation );
+        void       run( void );
+        bool       flush( void );
+
+        FrameFunc                   _framer     = nullptr;
+        uint16_t                    _chunkSize  = 0;
+        uint64_t                    _chunks     = 0;
+
+        //chunks of the current call
+        std::vector<ByteArray>      _views;             //into the input, not owned
+        std::vector<ByteArray*>     _outputs;
+        std::vector<StatusCode>     _status;
+        //outputs not yet appended to the output
+        uint16_t                    _pendingFirst = 0;
+        uint16_t                    _pendingLast  = 0;
+        uint16_t                    _sent         = 0;  //of the first pending one
+
+        //(generation << 32) | next chunk, a worker of an older call can not take one
+        std::atomic<uint64_t>       _ticket;
+        std::atomic<uint32_t>       _count;
+        std::atomic<uint32_t>       _finished;          //futex word of the calling thread
+        std::atomic<uint32_t>       _generation;        //futex word of the workers
+        std::atomic<bool>           _running;
+        std::vector<std::thread>    _workers;
+};
+
+#endif // __linux__
+
+#endif // _PARALLELPIPE_H_
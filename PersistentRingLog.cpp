@@ -0,0 +1,426 @@
+/**
+ * @file    PersistentRingLog.cpp
+ *
+ * @brief   Implementation of class PersistentRingLog
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#if defined( __unix__ )
+
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PersistentRingLog.h"
+
+
+#define RINGLOG_MAGIC   0x4C524747      //"GGRL"
+#define RINGLOG_VERSION 1
+
+
+/**
+  * @brief  class constructor, nothing is opened
+  *
+  * @param  -
+ */
+PersistentRingLog::PersistentRingLog( void ) {
+}
+
+
+/**
+  * @brief  class destructor, unmaps and closes the file
+  *
+  * @param  -
+ */
+PersistentRingLog::~PersistentRingLog( void ) {
+    close();
+}
+
+
+/**
+ * @brief   opens or creates the log file; a file with a valid header of the
+ *          same size is recovered as it is, anything else is reinitialised
+ *
+ * @param   path    file name
+ *          size    data area size
+ *
+ * @return  true if the log is ready
+ */
+bool
+PersistentRingLog::open( const char* path, uint32_t size ) {
+    close();
+    if ( 0 == size ) {
+        return false;
+    }
+
+    _fd = ::open( path, O_RDWR | O_CREAT | O_CLOEXEC, 0644 );
+    if ( _fd < 0 ) {
+        return false;
+    }
+
+    size_t length = sizeof( Header ) + size;
+    struct stat st;
+    if ( ( 0 != fstat( _fd, &st ) ) ||
+         ( ( (size_t)st.st_size != length ) && ( 0 != ftruncate( _fd, length ) ) ) ) {
+        close();
+        return false;
+    }
+
+    void* map = mmap( nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0 );
+    if ( MAP_FAILED == map ) {
+        close();
+        return false;
+    }
+    _header = (Header*)map;
+    _data   = (uint8_t*)map + sizeof( Header );
+    _size   = size;
+
+    //O(1) recovery: the header is the whole state
+    _recovered = ( RINGLOG_MAGIC   == _header->magic ) &&
+                 ( RINGLOG_VERSION == _header->version ) &&
+                 ( sizeof( Header ) == _header->headerSize ) &&
+                 ( size == _header->size ) &&
+                 ( _header->head >= _header->tail ) &&
+                 ( _header->head - _header->tail <= size );
+    if ( !_recovered ) {
+        _header->magic      = 0;
+        std::atomic_thread_fence( std::memory_order_release );
+        _header->version    = RINGLOG_VERSION;
+        _header->headerSize = sizeof( Header );
+        _header->size       = size;
+        _header->reserved   = 0;
+        _header->head       = 0;
+        _header->tail       = 0;
+        _header->sequence   = 0;
+        std::atomic_thread_fence( std::memory_order_release );
+        _header->magic      = RINGLOG_MAGIC;
+        msync( map, sizeof( Header ), MS_SYNC );
+    }
+    return true;
+}
+
+
+/**
+ * @brief   syncs, unmaps and closes the file
+ *
+ * @param   -
+ *
+ * @return  -
+ */
+void
+PersistentRingLog::close( void ) {
+    if ( _header ) {
+        sync();
+        munmap( _header, sizeof( Header ) + _size );
+    }
+    if ( 0 <= _fd ) {
+        ::close( _fd );
+    }
+    _fd        = -1;
+    _header    = nullptr;
+    _data      = nullptr;
+    _size      = 0;
+    _unsynced  = 0;
+    _recovered = false;
+}
+
+
+/**
+ * @brief   returns flag indicating that the file is mapped
+ *
+ * @param   -
+ *
+ * @return  log is open flag
+ */
+bool
+PersistentRingLog::isOpen( void ) const {
+    return nullptr != _header;
+}
+
+
+/**
+ * @brief   returns flag indicating that open() took over existing content
+ *
+ * @param   -
+ *
+ * @return  content was recovered flag
+ */
+bool
+PersistentRingLog::recovered( void ) const {
+    return _recovered;
+}
+
+
+/**
+ * @brief   returns size of the data area
+ *
+ * @param   -
+ *
+ * @return  ring size
+ */
+uint32_t
+PersistentRingLog::size( void ) const {
+    return _size;
+}
+
+
+/**
+ * @brief   returns size of data in the ring
+ *
+ * @param   -
+ *
+ * @return  byte count
+ */
+uint32_t
+PersistentRingLog::count( void ) const {
+    return _header ? (uint32_t)( _header->head - _header->tail ) : 0;
+}
+
+
+/**
+ * @brief   returns flag indicating that bufer is empty
+ *
+ * @param   -
+ *
+ * @return  buffer is empty flag
+ */
+bool
+PersistentRingLog::isEmpty( void ) const {
+    return 0 == count();
+}
+
+
+/**
+ * @brief   returns flag indicating that bufer is full
+ *
+ * @param   -
+ *
+ * @return  buffer is full flag
+ */
+bool
+PersistentRingLog::isFull( void ) const {
+    return _header && ( _size == count() );
+}
+
+
+/**
+ * @brief   returns the number of put operations over the life of the file
+ *
+ * @param   -
+ *
+ * @return  sequence number
+ */
+uint64_t
+PersistentRingLog::sequence( void ) const {
+    return _header ? _header->sequence : 0;
+}
+
+
+/**
+ * @brief   effectively clears the content of the log
+ *
+ * @param   -
+ *
+ * @return  -
+ */
+void
+PersistentRingLog::clear( void ) {
+    if ( _header ) {
+        advanceTail( _header->head );
+    }
+}
+
+
+/**
+ * @brief   puts a byte, the oldest one is dropped when full
+ *
+ * @param   abyte   byte to put
+ *
+ * @return  -
+ */
+void
+PersistentRingLog::put( uint8_t abyte ) {
+    put( &abyte, 1 );
+}
+
+
+/**
+ * @brief   puts n bytes, the oldest ones are dropped when full;
+ *          more than size() bytes keep only the newest size() of them
+ *
+ * @param   data    bytes to put
+ *          n       byte count
+ *
+ * @return  bytes put
+ */
+uint32_t
+PersistentRingLog::put( const uint8_t* data, uint32_t n ) {
+    if ( !_header || ( 0 == n ) ) {
+        return 0;
+    }
+    if ( n > _size ) {
+        data += n - _size;
+        n     = _size;
+    }
+    uint64_t head = _header->head;
+    //drop the oldest bytes before they are overwritten
+    if ( head - _header->tail + n > _size ) {
+        advanceTail( head + n - _size );
+    }
+    uint32_t offset = (uint32_t)( head % _size );
+    uint32_t first  = _size - offset;
+    if ( first > n ) {
+        first = n;
+    }
+    std::memcpy( _data + offset, data, first );
+    std::memcpy( _data, data + first, n - first );
+    advanceHead( head + n );
+    putDone();
+    return n;
+}
+
+
+/**
+ * @brief   return byte at index, 0 is the oldest, does not change the log
+ *
+ * @param   index  byte index
+ *
+ * @return  byte at position index, 0 if out of range
+ */
+uint8_t
+PersistentRingLog::at( uint32_t index ) const {
+    if ( index >= count() ) {
+        return 0;
+    }
+    return _data[( _header->tail + index ) % _size];
+}
+
+
+/**
+ * @brief   returns oldest byte, advances tail
+ *
+ * @param   -
+ *
+ * @return  byte at tail, 0 if empty
+ */
+uint8_t
+PersistentRingLog::get( void ) {
+    uint8_t abyte = 0;
+    get( &abyte, 1 );
+    return abyte;
+}
+
+
+/**
+ * @brief   takes up to n oldest bytes
+ *
+ * @param   data    destination
+ *          n       max byte count
+ *
+ * @return  bytes taken
+ */
+uint32_t
+PersistentRingLog::get( uint8_t* data, uint32_t n ) {
+    uint32_t filled = count();
+    if ( n > filled ) {
+        n = filled;
+    }
+    if ( 0 == n ) {
+        return 0;
+    }
+    uint64_t tail   = _header->tail;
+    uint32_t offset = (uint32_t)( tail % _size );
+    uint32_t first  = _size - offset;
+    if ( first > n ) {
+        first = n;
+    }
+    std::memcpy( data, _data + offset, first );
+    std::memcpy( data + first, _data, n - first );
+    advanceTail( tail + n );
+    return n;
+}
+
+
+/**
+ * @brief   msync every puts put operations, 0 leaves it to sync() and the OS
+ *
+ * @param   puts    put operations between msync calls
+ *
+ * @return  -
+ */
+void
+PersistentRingLog::setSyncInterval( uint32_t puts ) {
+    _syncInterval = puts;
+}
+
+
+/**
+ * @brief   flushes the mapping to the file
+ *
+ * @param   -
+ *
+ * @return  true on success
+ */
+bool
+PersistentRingLog::sync( void ) {
+    _unsynced = 0;
+    if ( !_header ) {
+        return false;
+    }
+    return 0 == msync( _header, sizeof( Header ) + _size, MS_SYNC );
+}
+
+
+/**
+ * @brief   header update, ordered after everything written before it
+ *
+ * @param   tail    new tail total
+ *
+ * @return  -
+ */
+void
+PersistentRingLog::advanceTail( uint64_t tail ) {
+    std::atomic_thread_fence( std::memory_order_release );
+    _header->tail = tail;
+}
+
+
+/**
+ * @brief   header update, ordered after the data it publishes
+ *
+ * @param   head    new head total
+ *
+ * @return  -
+ */
+void
+PersistentRingLog::advanceHead( uint64_t head ) {
+    std::atomic_thread_fence( std::memory_order_release );
+    _header->head = head;
+}
+
+
+/**
+ * @brief   counts the put and issues the batched msync
+ *
+ * @param   -
+ *
+ * @return  -
+ */
+void
+PersistentRingLog::putDone( void ) {
+    _header->sequence = _header->sequence + 1;
+    if ( _syncInterval && ( ++_unsynced >= _syncInterval ) ) {
+        sync();
+    }
+}
+
+#endif // __unix__
@@ -0,0 +1,93 @@
+/**
+ * @file    PersistentRingLog.h
+ *
+ * @brief   Declaration of class PersistentRingLog
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _PersistentRingLog_H_
+#define _PersistentRingLog_H_
+
+#if defined( __unix__ )
+
+#include <stdint.h>
+
+/**
+ * @brief   The PersistentRingLog class is a CircularBuffer kept in a mmap'd file,
+ *          so its content survives a crash or a restart of the process.
+ *          The file starts with a small header holding head and tail as free
+ *          running byte totals plus a sequence number; data is always written
+ *          before the header is advanced, so reopening is an O(1) header check.
+ *          As CircularBuffer::put, put overwrites the oldest bytes when full.
+ *          msync is issued every setSyncInterval() puts or by sync(), the page
+ *          cache alone already covers a process crash.
+ */
+
+class PersistentRingLog {
+    public:
+
+                        PersistentRingLog( void );
+                       ~PersistentRingLog( void );
+
+                        PersistentRingLog( const PersistentRingLog& other ) = delete;
+        PersistentRingLog& operator = ( const PersistentRingLog& other ) = delete;
+
+        bool            open(   const char* path, uint32_t size );
+        void            close(  void );
+        bool            isOpen( void ) const;
+        bool            recovered( void ) const;
+
+        uint32_t        size(   void ) const;
+        uint32_t        count(  void ) const;
+        bool            isEmpty( void ) const;
+        bool            isFull( void ) const;
+        uint64_t        sequence( void ) const;
+
+        void            clear(  void );
+
+        void            put(    uint8_t abyte );
+        uint32_t        put(    const uint8_t* data, uint32_t n );
+
+        uint8_t         at(     uint32_t index ) const;
+        uint8_t         get(    void );
+        uint32_t        get(    uint8_t* data, uint32_t n );
+
+        void            setSyncInterval( uint32_t puts );
+        bool            sync(   void );
+
+    private:
+
+        //<! file layout, data follows the header
+        struct Header {
+            uint32_t    magic;
+            uint16_t    version;
+            uint16_t    headerSize;
+            uint32_t    size;       //data area size
+            uint32_t    reserved;
+            uint64_t    head;       //total bytes ever put
+            uint64_t    tail;       //total bytes ever dropped or taken
+            uint64_t    sequence;   //put operations
+        };
+
+        void            advanceTail( uint64_t tail );
+        void            advanceHead( uint64_t head );
+        void            putDone( void );
+
+        int             _fd             = -1;
+        Header*         _header         = nullptr;
+        uint8_t*        _data           = nullptr;
+        uint32_t        _size           = 0;
+        uint32_t        _syncInterval   = 0;
+        uint32_t        _unsynced       = 0;
+        bool            _recovered      = false;
+};
+
+#endif // __unix__
+
+#endif // _PersistentRingLog_H_
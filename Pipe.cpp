@@ -13,6 +13,8 @@
 
 
 #include "Pipe.h"
+
+#include <cstring>
 //#include <algorithm>
 //in ByteArray.h
 
@@ -20,6 +22,19 @@
 Pipe::Pipe( ByteArray* pInput_data, ProcessorFunc processor, ByteArray* pOutput_data )
     : _pInput_data( pInput_data ), _processor( processor ), _pOutput_data( pOutput_data ) {}
 
+//Constructor with a context processor
+Pipe::Pipe( ByteArray* pInput_data, ProcessorCtxFunc processor, void* context, ByteArray* pOutput_data )
+    : _pInput_data( pInput_data ), _pOutput_data( pOutput_data ), _processor( nullptr ),
+      _processorCtx( processor ), _context( context ) {}
+
+//Constructor with a batch processor
+Pipe::Pipe( ByteArray* pInput_data, BatchProcessorFunc processor, ByteArray* pOutput_data )
+    : _pInput_data( pInput_data ), _pOutput_data( pOutput_data ), _processor( nullptr ),
+      _processorBatch( processor ) {}
+
+//Destructor, the buffers belong to the Pipeline
+Pipe::~Pipe() {}
+
 //Process method implementation
 StatusCode Pipe::process() {
 #if EXCEPTIONS_SUPPORTED
@@ -27,6 +42,13 @@ StatusCode Pipe::process() {
             //Clear the output buffer before processing
             //pOutput_data->clear();
             //Process the input data and store the result in the output data
+            if ( _processorCtx ) {
+                return _processorCtx( _pInput_data, _pOutput_data, _context );
+            }
+            if ( _processorBatch ) {
+                BatchBudget unit = { 1, 0xFFFF, 0, 0 };
+                return _processorBatch( _pInput_data, _pOutput_data, &unit );
+            }
             return _processor( _pInput_data, _pOutput_data );
         } catch (...) {
             return StatusCode::ERROR;
@@ -35,10 +57,47 @@ StatusCode Pipe::process() {
         //Clear the output buffer before processing
         //pOutput_data->clear();
         //Process the input data and store the result in the output data
+        if ( _processorCtx ) {
+            return _processorCtx( _pInput_data, _pOutput_data, _context );
+        }
+        if ( _processorBatch ) {
+            //one unit, as processAll() expects
+            BatchBudget unit = { 1, 0xFFFF, 0, 0 };
+            return _processorBatch( _pInput_data, _pOutput_data, &unit );
+        }
         return _processor( _pInput_data, _pOutput_data );
 #endif
     }
 
+//Batch method implementation: a batch processor gets the budget,
+//any other processor is called while it returns OK and budget is left
+StatusCode Pipe::processBatch( BatchBudget* pBudget ) {
+    pBudget->items = 0;
+    pBudget->bytes = 0;
+    if ( _processorBatch ) {
+#if EXCEPTIONS_SUPPORTED
+        try {
+            return _processorBatch( _pInput_data, _pOutput_data, pBudget );
+        } catch (...) {
+            return StatusCode::ERROR;
+        }
+#else
+        return _processorBatch( _pInput_data, _pOutput_data, pBudget );
+#endif
+    }
+    StatusCode status;
+    do {
+        uint16_t before = _pInput_data ? _pInput_data->count() : 0;
+        status = process();
+        ++pBudget->items;
+        if ( _pInput_data && ( _pInput_data->count() < before ) ) {
+            pBudget->bytes += before - _pInput_data->count();
+        }
+    } while ( ( StatusCode::OK == status ) &&
+              ( pBudget->items < pBudget->maxItems ) && ( pBudget->bytes < pBudget->maxBytes ) );
+    return status;
+}
+
 //Get the input buffer
 ByteArray* Pipe::getInputBuffer( void ) const {
     return _pInput_data;
@@ -49,6 +108,11 @@ ByteArray* Pipe::getOutputBuffer( void ) const {
     return _pOutput_data;
 }
 
+//Get the context of a context processor
+void* Pipe::getContext( void ) const {
+    return _context;
+}
+
 //Set the input buffer, even nullptr is allowed
 void Pipe::setInputBuffer( ByteArray* pInput_data ) {
     _pInput_data = pInput_data;
@@ -64,3 +128,33 @@ void Pipe::setOutputBuffer( ByteArray* pOutput_data ) {
 void Pipe::swapIO( void ) {
     std::swap( _pInput_data, _pOutput_data );
 }
+
+
+//Zero copy pass-through, also the tail call of inspecting processors.
+//The storage is swapped only if ByteArray::canSwap(), e.g. both buffers
+//come from one BufferPool, otherwise it is copied. A CircularBuffer is not
+//laid out from data() on, it is refused.
+StatusCode Pipe::forward( ByteArray* pInput_data, ByteArray* pOutput_data ) {
+    if ( !pInput_data || !pOutput_data || !pInput_data->isLinear() || !pOutput_data->isLinear() ) {
+        return StatusCode::ERROR;
+    }
+    if ( 0 == pInput_data->count() ) {
+        return StatusCode::NEXT;
+    }
+    if ( 0 == pOutput_data->count() && pInput_data->swap( *pOutput_data ) ) {
+        return StatusCode::NEXT;
+    }
+    //downstream has not drained yet: copy what fits
+    uint16_t n = pOutput_data->size() - pOutput_data->count();
+    if ( n > pInput_data->count() ) {
+        n = pInput_data->count();
+    }
+    if ( 0 == n ) {
+        return StatusCode::OK;          //let the next pipes drain
+    }
+    std::memcpy( pOutput_data->data() + pOutput_data->count(), pInput_data->data(), n );
+    std::memmove( pInput_data->data(), pInput_data->data() + n, pInput_data->count() - n );
+    pOutput_data->update_count( pOutput_data->count() + n );
+    pInput_data->update_count( pInput_data->count() - n );
+    return StatusCode::NEXT;
+}
@@ -33,32 +33,66 @@ enum class StatusCode {
 };
 
 
+//processing budget of one batched call, the stage fills in what it consumed
+struct BatchBudget {
+    uint16_t    maxItems;       //units the stage may process
+    uint16_t    maxBytes;       //input bytes the stage may consume
+    uint16_t    items;          //units processed
+    uint16_t    bytes;          //input bytes consumed
+};
+
+
 class Pipe {
 
     public:
 
-        using ProcessorFunc = StatusCode (*)( ByteArray*, ByteArray* );
+        using ProcessorFunc     = StatusCode (*)( ByteArray*, ByteArray* );
+        using ProcessorCtxFunc  = StatusCode (*)( ByteArray*, ByteArray*, void* );
+        //OK: budget used up and more is left, NEXT: all done, PENDING: needs input
+        using BatchProcessorFunc = StatusCode (*)( ByteArray*, ByteArray*, BatchBudget* );
 
         Pipe( 
             ByteArray* pInput_data,
             ProcessorFunc processor,
             ByteArray* pOutput_data = nullptr
         );
+        //one processor for many pipes, each with its own state in context
+        Pipe(
+            ByteArray* pInput_data,
+            ProcessorCtxFunc processor,
+            void* context,
+            ByteArray* pOutput_data = nullptr
+        );
+        Pipe(
+            ByteArray* pInput_data,
+            BatchProcessorFunc processor,
+            ByteArray* pOutput_data = nullptr
+        );
+        virtual    ~Pipe();
 
-        StatusCode process();
+        virtual StatusCode process();
+        virtual StatusCode processBatch( BatchBudget* pBudget );   //many units per call
 
         ByteArray* getInputBuffer() const;
         ByteArray* getOutputBuffer() const;
+        void*      getContext() const;
         void       setInputBuffer( ByteArray* pInput_data );
         void       setOutputBuffer( ByteArray* pOutput_data );
 
         void       swapIO( void ); //void swapBuffers();
 
+        //pass-through processor: hands the input over to an empty output
+        //without copying, copies only if the output still holds data
+        static StatusCode forward( ByteArray* pInput_data, ByteArray* pOutput_data );
+
     protected:
 
         ByteArray*      _pInput_data;
         ByteArray*      _pOutput_data;
         ProcessorFunc   _processor;
+        ProcessorCtxFunc _processorCtx  = nullptr;
+        void*           _context        = nullptr;
+        BatchProcessorFunc _processorBatch = nullptr;
 
 };
 
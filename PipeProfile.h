@@ -0,0 +1,163 @@
+/**
+ * @file    PipeProfile.h
+ *
+ * @brief   Declaration of the Pipeline profiling counters
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _PIPEPROFILE_H_
+#define _PIPEPROFILE_H_
+
+
+//0 compiles the profiling out of Pipeline, 1 makes it switchable at runtime
+#ifndef PIPELINE_PROFILING
+#define PIPELINE_PROFILING 1
+#endif
+
+
+#include <chrono>
+#include <cstring>
+#include <stdint.h>
+
+
+//monotonic nanoseconds, the clock of profiling and tracing
+inline uint64_t pipelineNow( void ) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+
+/*
+ * LatencyHistogram is a log-linear histogram in the HDR style: values below
+ * 16 have a bucket each, above that every power of two is split into 8
+ * buckets, so any value is kept with 3 significant bits (12.5% error) over
+ * the whole uint64_t range in 496 counters.
+ */
+
+class LatencyHistogram {
+
+public:
+    static constexpr uint16_t BucketCount = 16 + 60 * 8;
+
+    LatencyHistogram() {
+        clear();
+    }
+
+    void clear() {
+        std::memset( _buckets, 0, sizeof( _buckets ) );
+        _count = 0;
+        _sum   = 0;
+        _min   = UINT64_MAX;
+        _max   = 0;
+    }
+
+    void record( uint64_t value ) {
+        ++_buckets[bucketOf( value )];
+        ++_count;
+        _sum += value;
+        if ( value < _min ) {
+            _min = value;
+        }
+        if ( value > _max ) {
+            _max = value;
+        }
+    }
+
+    uint64_t count() const {
+        return _count;
+    }
+
+    uint64_t min() const {
+        return _count ? _min : 0;
+    }
+
+    uint64_t max() const {
+        return _max;
+    }
+
+    double mean() const {
+        return _count ? (double)_sum / _count : 0.0;
+    }
+
+    //highest value of the bucket holding the p-th percentile, p in 0..100
+    uint64_t percentile( double p ) const {
+        if ( 0 == _count ) {
+            return 0;
+        }
+        uint64_t target = (uint64_t)( p / 100.0 * _count + 0.5 );
+        if ( target < 1 ) {
+            target = 1;
+        }
+        uint64_t seen = 0;
+        for ( uint16_t b = 0; b < BucketCount; ++b ) {
+            seen += _buckets[b];
+            if ( seen >= target ) {
+                uint64_t upper = upperOf( b );
+                return ( upper < _max ) ? upper : _max;
+            }
+        }
+        return _max;
+    }
+
+    uint32_t bucket( uint16_t index ) const {
+        return ( index < BucketCount ) ? _buckets[index] : 0;
+    }
+
+    static uint16_t bucketOf( uint64_t value ) {
+        if ( value < 16 ) {
+            return (uint16_t)value;
+        }
+        uint8_t exponent = 63 - __builtin_clzll( value );          //4..63
+        uint8_t sub      = ( value >> ( exponent - 3 ) ) & 7;
+        return 16 + ( exponent - 4 ) * 8 + sub;
+    }
+
+    static uint64_t upperOf( uint16_t index ) {
+        if ( index < 16 ) {
+            return index;
+        }
+        uint8_t  exponent = ( index - 16 ) / 8 + 4;
+        uint64_t sub      = ( index - 16 ) % 8;
+        uint64_t lower    = ( 8 + sub ) << ( exponent - 3 );
+        return lower + ( (uint64_t)1 << ( exponent - 3 ) ) - 1;
+    }
+
+private:
+    uint32_t    _buckets[BucketCount];
+    uint64_t    _count;
+    uint64_t    _sum;
+    uint64_t    _min;
+    uint64_t    _max;
+};
+
+
+//what Pipeline counts per pipe while profiling is on
+struct PipeStats {
+    uint64_t            calls;
+    uint64_t            statusCount[6];     //indexed by StatusCode
+    uint64_t            bytesIn;            //taken from the input buffer
+    uint64_t            bytesOut;           //added to the output buffer
+    uint64_t            stalls;             //not run, output short of credits
+    LatencyHistogram    latency;            //ns per call
+
+    PipeStats() {
+        clear();
+    }
+
+    void clear() {
+        calls    = 0;
+        std::memset( statusCount, 0, sizeof( statusCount ) );
+        bytesIn  = 0;
+        bytesOut = 0;
+        stalls   = 0;
+        latency.clear();
+    }
+};
+
+#endif // _PIPEPROFILE_H_
@@ -14,6 +14,14 @@
 
 #include "Pipeline.h"
 
+#include <cstring>
+
+#if defined( __linux__ )
+#include <cerrno>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
 
 //Constructor with default buffer size
 //if the size is given 0, no buffers are created
@@ -38,13 +46,22 @@ Pipeline::Pipeline( ByteArray* pBAin ) :
 
 //Destructor to clean up dynamically allocated objects
 Pipeline::~Pipeline() {
+    //ByteArray frees its own data
     for ( auto buffer : _buffers ) {
-        delete[] buffer->data();
-        delete buffer;
+        if ( _pool && _pool->owns( buffer ) ) {
+            _pool->release( buffer );
+        } else {
+            delete buffer;
+        }
     }
     for ( auto pipe : _pipes ) {
         delete pipe;
     }
+#if defined( __linux__ )
+    if ( 0 <= _eventFd ) {
+        close( _eventFd );
+    }
+#endif
 }
 
 
@@ -113,6 +130,24 @@ uint8_t    Pipeline::AddBuffer( ByteArray* pByteArray ) {
     return _buffers.size() - 1;
 }
 
+//Add a buffer from a pool, one pool per pipeline
+uint8_t    Pipeline::AddBuffer( BufferPool* pPool ) {
+
+    _faultyPipe = 0;
+
+    ByteArray* pByteArray = ( pPool && ( !_pool || _pool == pPool ) ) ? pPool->acquire() : nullptr;
+    if ( !pByteArray ) {
+        //same error convention as AddBuffer( int )
+        _faultyPipe = _pipes.size() + 1;
+        return 0;
+    }
+
+    _pool = pPool;
+    _buffers.push_back( pByteArray );
+    return _buffers.size() - 1;
+
+}
+
 
 /* Add processors */
 
@@ -225,6 +260,49 @@ StatusCode Pipeline::AddProcessor(
 
 }
 
+StatusCode Pipeline::AddProcessor(
+    ByteArray* inputBuffer, Pipe::ProcessorCtxFunc processor, void* context, ByteArray* outputBuffer ) {
+
+    //Create a new Pipe with these buffers and the processor's state
+    Pipe* newPipe           = new Pipe( inputBuffer, processor, context, outputBuffer );
+    if ( !newPipe ) {
+        return StatusCode::ERROR;
+    }
+
+    _pipes.push_back( newPipe );
+
+    return StatusCode::OK;
+
+}
+
+StatusCode Pipeline::AddProcessor(
+    ByteArray* inputBuffer, Pipe::BatchProcessorFunc processor, ByteArray* outputBuffer ) {
+
+    //Create a new Pipe with these buffers
+    Pipe* newPipe           = new Pipe( inputBuffer, processor, outputBuffer );
+    if ( !newPipe ) {
+        return StatusCode::ERROR;
+    }
+
+    _pipes.push_back( newPipe );
+
+    return StatusCode::OK;
+
+}
+
+//Add a ready made pipe, e.g. a derived one, the pipeline deletes it
+StatusCode Pipeline::AddProcessor( Pipe* pPipe ) {
+
+    if ( !pPipe ) {
+        return StatusCode::ERROR;
+    }
+
+    _pipes.push_back( pPipe );
+
+    return StatusCode::OK;
+
+}
+
 
 /* Getters for _buffers */
 
@@ -328,6 +406,7 @@ StatusCode Pipeline::Sink( uint8_t PipeIndex, char c ) {
 
         //Append the character to the buffer
         targetBuffer->append( c );
+        markReady( PipeIndex );
 
         return StatusCode::OK;
 
@@ -339,7 +418,36 @@ StatusCode Pipeline::Sink( uint8_t PipeIndex, char c ) {
 
 
 //works with ByteArray buffers
+//appends what fits and reports ERROR if that was not the whole string
 StatusCode Pipeline::Sink( uint8_t PipeIndex, const char* cstring ) {
+    if ( !cstring ) {
+        return StatusCode::ERROR;
+    }
+    size_t length = strlen( cstring );
+    uint16_t accepted = 0;
+    StatusCode status = Sink( PipeIndex, (const uint8_t*)cstring,
+                              ( length < 0xFFFF ) ? (uint16_t)length : 0xFFFF, &accepted );
+    if ( ( StatusCode::PARTIAL == status ) || ( accepted < length ) ) {
+        return StatusCode::ERROR;   //Failed to append character
+    }
+    return status;
+}
+
+//works with ByteArray buffers
+StatusCode Pipeline::Sink( uint8_t PipeIndex, ByteArray* pByteArray ) {
+    if ( !pByteArray ) {
+        return StatusCode::ERROR;
+    }
+    return Sink( PipeIndex, pByteArray->data(), pByteArray->count() );
+}
+
+//works with ByteArray buffers, one memcpy of as much as fits,
+//PARTIAL with *pAccepted when the input has less space than size
+StatusCode Pipeline::Sink( uint8_t PipeIndex, const uint8_t* data, uint16_t size, uint16_t* pAccepted ) {
+
+    if ( pAccepted ) {
+        *pAccepted = 0;
+    }
 
     if ( PipeIndex > 0 && PipeIndex <= _pipes.size() ) {
 
@@ -351,20 +459,18 @@ StatusCode Pipeline::Sink( uint8_t PipeIndex, const char* cstring ) {
             return StatusCode::ERROR;  //Invalid or uninitialized buffer
         }
 
-        //Check if there is space to append the character
-        if ( targetBuffer->count() >= targetBuffer->size() ) {
-            return StatusCode::ERROR;  //Buffer overflow
+        //a full input is backpressure, nothing is accepted
+        uint16_t accepted = targetBuffer->append( data, size );
+        if ( pAccepted ) {
+            *pAccepted = accepted;
+        }
+        if ( accepted ) {
+            markReady( PipeIndex );
         }
 
-        //Append each character of the C-string to the buffer
-        uint16_t offset = 0;
-        uint16_t OffsetLimit = targetBuffer->size() - targetBuffer->count();
-        char ch;
-        while ( '\0' != ( ch = *( cstring + offset++ ) ) ) {
-            if ( offset > OffsetLimit ) {
-                return StatusCode::ERROR;   //Failed to append character
-            }
-            targetBuffer->append( ch );
+        //Determine the status based on whether all data was appended
+        if ( accepted < size ) {
+            return StatusCode::PARTIAL;     //Only part of the data was appended
         }
 
         return StatusCode::OK;
@@ -375,43 +481,55 @@ StatusCode Pipeline::Sink( uint8_t PipeIndex, const char* cstring ) {
 
 }
 
-//works with ByteArray buffers
-StatusCode Pipeline::Sink( uint8_t PipeIndex, ByteArray* pByteArray ) {
+//read() straight into the free space of the pipe input, once:
+//OK data was read, PENDING nothing to read now (EAGAIN) or no space,
+//NEXT end of stream, ERROR read failed or no such pipe
+StatusCode Pipeline::SinkFromFd( uint8_t PipeIndex, int fd, uint16_t* pRead ) {
 
-    if ( PipeIndex > 0 && PipeIndex <= _pipes.size() ) {
+    if ( pRead ) {
+        *pRead = 0;
+    }
+
+#if defined( __linux__ )
+    if ( PipeIndex > 0 && PipeIndex <= _pipes.size() && 0 <= fd ) {
 
         _pipeOffset = PipeIndex - 1;
 
-        //Get the specified buffer
         ByteArray* targetBuffer = _pipes[_pipeOffset]->getInputBuffer();
         if ( !targetBuffer || !targetBuffer->data() ) {
             return StatusCode::ERROR;  //Invalid or uninitialized buffer
         }
 
-        //Check if there is space to append the character
-        if ( targetBuffer->count() >= targetBuffer->size() ) {
-            return StatusCode::ERROR;  //Buffer overflow
-        }
-
-        //Calculate how much space is available in the target buffer
         uint16_t space = targetBuffer->size() - targetBuffer->count();
+        if ( 0 == space ) {
+            return StatusCode::PENDING;
+        }
 
-        //Calculate how much data can be appended from the source buffer
-        space = pByteArray->count() <= space ? pByteArray->count() : space;
+        ssize_t got;
+        do {
+            got = read( fd, targetBuffer->data() + targetBuffer->count(), space );
+        } while ( ( got < 0 ) && ( EINTR == errno ) );
 
-        //Append as much data as possible from pByteArray to targetBuffer
-        for ( uint16_t i = 0; i < space; ) {
-            targetBuffer->append( pByteArray->at( i++ ) );
+        if ( got < 0 ) {
+            return ( ( EAGAIN == errno ) || ( EWOULDBLOCK == errno ) ) ?
+                StatusCode::PENDING : StatusCode::ERROR;
         }
-
-        //Determine the status based on whether all data was appended
-        if ( space < pByteArray->count() ) {
-            return StatusCode::PARTIAL;     //Only part of the data was appended
+        if ( 0 == got ) {
+            return StatusCode::NEXT;    //end of stream
         }
 
+        targetBuffer->update_count( targetBuffer->count() + got );
+        if ( pRead ) {
+            *pRead = got;
+        }
+        markReady( PipeIndex );
         return StatusCode::OK;
 
     }
+#else
+    (void)PipeIndex;
+    (void)fd;
+#endif
 
     return StatusCode::ERROR;
 
@@ -423,7 +541,11 @@ StatusCode Pipeline::Sink( uint8_t PipeIndex, ByteArray* pByteArray ) {
 StatusCode Pipeline::processStep( uint8_t i ) {
     if ( i > 0 && i <= _pipes.size() ) {
         _faultyPipe = 0;            //Reset the faulty pipe indicator
-        StatusCode status = _pipes[i-1]->process();
+        if ( !hasCredits( i - 1 ) ) {
+            _faultyPipe = i;        //Count pipes from 1
+            return StatusCode::PENDING;     //output full
+        }
+        StatusCode status = runPipe( i - 1 );
         if ( ( status != StatusCode::NEXT ) && ( status != StatusCode::OK ) ) {
             _faultyPipe = i;        //Count pipes from 1
             if ( _ErrorHandler ) {
@@ -440,7 +562,7 @@ StatusCode Pipeline::processStep( uint8_t i ) {
 #define DebugFrom  3
 
 StatusCode Pipeline::processAll() {
-    StatusCode  status;
+    StatusCode  status      = StatusCode::NEXT;    //nothing left after _pipeOffset
     //take into account _pipeOffset and reset it
 #if 0 < DebugSteps
     if ( ( DebugFrom - 1 ) <= _pipeOffset ) {
@@ -454,6 +576,7 @@ StatusCode Pipeline::processAll() {
     }
 #endif
     uint8_t i           = _pipeOffset;
+    uint8_t held        = 0;                    //first pipe short of credits, from 1
     _pipeOffset         = 0;
     //Reset the faulty pipe indicator
     _faultyPipe         = 0;
@@ -465,7 +588,13 @@ StatusCode Pipeline::processAll() {
             printf("Processing pipe %d\r\n", i + 1 );
         }
 #endif
-        status = _pipes[i]->process();
+        if ( !hasCredits( i ) ) {       //output full, the pipes after it drain it first
+            if ( !held ) {
+                held = i + 1;           //Count pipes from 1
+            }
+            continue;
+        }
+        status = runPipe( i );
 #if 2 < DebugSteps
         if ( ( DebugFrom - 1 ) <= i ) {
             printf("Pipe result: %d\r\n", status );
@@ -482,6 +611,10 @@ StatusCode Pipeline::processAll() {
             //break;
         
         case StatusCode::PENDING:       //finish time quant, set stalled Pipe, restart pipeline
+            if ( held && hasCredits( held - 1 ) ) {
+                _pipeOffset = held - 1; //drained meanwhile, it goes on first
+                return StatusCode::OK;
+            }
             _faultyPipe = i + 1;        //Count pipes from 1
             return status;
 
@@ -511,11 +644,381 @@ StatusCode Pipeline::processAll() {
             return status;
         }
     }
+    if ( held ) {
+        if ( hasCredits( held - 1 ) ) {
+            _pipeOffset = held - 1;     //the pipes after it drained its output, it goes on first
+            return StatusCode::OK;
+        }
+        _faultyPipe = held;             //still full, waits for the back end to drain
+        return StatusCode::PENDING;
+    }
     return status;
 }
 
+//Batched alternative to processAll(): every pipe handles up to maxItems
+//units or maxBytes input bytes per call, so the loop overhead is paid once
+//per batch. OK and REPEAT do not end the quantum, the batch goes on
+//downstream at once; a PENDING pipe is left and the next ones still run.
+//Returns OK if some pipe has more, PENDING if some pipe waits for input.
+StatusCode Pipeline::processBatch( uint16_t maxItems, uint16_t maxBytes ) {
+    BatchBudget budget;
+    StatusCode  status;
+    bool        more    = false;
+    uint8_t     i       = _pipeOffset;
+    uint8_t     held    = 0;            //first pipe short of credits, from 1
+    _pipeOffset         = 0;
+    _faultyPipe         = 0;
+    for ( ; i < _pipes.size(); ++i ) {
+        if ( !hasCredits( i ) ) {       //output full, the pipes after it drain it first
+            if ( !held ) {
+                held = i + 1;           //Count pipes from 1
+            }
+            continue;
+        }
+        budget.maxItems = maxItems;
+        budget.maxBytes = maxBytes;
+        status = runPipe( i, &budget );
+        switch ( status ) {
+        case StatusCode::NEXT:          //took everything it had
+            break;
+
+        case StatusCode::OK:            //budget used up, more is left
+        case StatusCode::REPEAT:
+            more = true;
+            break;
+
+        case StatusCode::PENDING:       //waits for input, the first one is reported
+            if ( !_faultyPipe ) {
+                _faultyPipe = i + 1;    //Count pipes from 1
+            }
+            break;
+
+        default:                        //PARTIAL, ERROR
+            _faultyPipe = i + 1;        //Count pipes from 1
+            if ( _ErrorHandler ) {
+                _ErrorHandler( this, status );
+            }
+            return status;
+        }
+    }
+    if ( held && hasCredits( held - 1 ) ) {
+        more = true;                    //drained meanwhile, it goes on next call
+    } else if ( held && !_faultyPipe ) {
+        _faultyPipe = held;             //still full, waits for the back end to drain
+    }
+    if ( more ) {
+        return StatusCode::OK;
+    }
+    return _faultyPipe ? StatusCode::PENDING : StatusCode::NEXT;
+}
+
+
+/* Flow control */
+
+//With credits set, a pipe is scheduled only with at least its minimum of
+//credits, free bytes in its output. A full edge so holds back its producer
+//instead of making it drop or fail, the pipes after it drain it first, and
+//the pressure goes up to the front end, where Sink() reports PARTIAL.
+//Without them (0, the default) the pipe always runs, as it always did.
+bool Pipeline::hasCredits( uint8_t i ) {
+    uint16_t need = ( i < _minCredits.size() ) ? _minCredits[i] : 0;
+    ByteArray* output = _pipes[i]->getOutputBuffer();
+    if ( !need || !output ) {
+        return true;
+    }
+    if ( output->size() - output->count() >= need ) {
+        return true;
+    }
+#if PIPELINE_PROFILING
+    if ( _profiling ) {
+        if ( _stats.size() < _pipes.size() ) {
+            _stats.resize( _pipes.size() );
+        }
+        ++_stats[i].stalls;
+    }
+#endif
+    return false;
+}
+
+//Count pipes from 1, 0 turns credits off, the pipe runs even with a full output
+void Pipeline::setMinCredits( uint8_t PipeIndex, uint16_t credits ) {
+    if ( PipeIndex > 0 && PipeIndex <= _pipes.size() ) {
+        if ( _minCredits.size() < _pipes.size() ) {
+            _minCredits.resize( _pipes.size(), 0 );
+        }
+        _minCredits[PipeIndex - 1] = credits;
+    }
+}
+
+//Count pipes from 1, free bytes of the output, 0xFFFF without one
+uint16_t Pipeline::getCredits( uint8_t PipeIndex ) const {
+    if ( PipeIndex > 0 && PipeIndex <= _pipes.size() ) {
+        ByteArray* output = _pipes[PipeIndex - 1]->getOutputBuffer();
+        return output ? output->size() - output->count() : 0xFFFF;
+    }
+    return 0;
+}
+
+
+/* Readiness driven processing */
+
+//A pipe is ready when its input gained data or its output gained space.
+//processReady() runs only the ready pipes, in order, once each:
+//OK and REPEAT keep a pipe ready, NEXT and PENDING make it wait until
+//a neighbour or Sink() marks it again, errors park it too.
+//Data put into a buffer from outside needs markReady() of its consumer,
+//a back end emptied from outside markReady() of its producer.
+
+//Give pipes added since the last call their ready flag
+void Pipeline::syncReady( void ) {
+    while ( _ready.size() < _pipes.size() ) {
+        _ready.push_back( 1 );
+        ++_readyCount;
+    }
+}
+
+void Pipeline::setReady( uint8_t i, bool ready ) {
+    if ( _ready[i] == ready ) {
+        return;
+    }
+    _ready[i] = ready;
+    if ( ready ) {
+        ++_readyCount;
+    } else {
+        --_readyCount;
+    }
+}
+
+//Count pipes from 1
+void Pipeline::markReady( uint8_t PipeIndex ) {
+    syncReady();
+    if ( PipeIndex > 0 && PipeIndex <= _pipes.size() ) {
+        setReady( PipeIndex - 1, true );
+        updateEvent();
+    }
+}
+
+//level semantics: the eventfd is readable exactly while something is ready
+void Pipeline::updateEvent( void ) {
+#if defined( __linux__ )
+    if ( _eventFd < 0 || ( _eventSignalled == ( 0 != _readyCount ) ) ) {
+        return;
+    }
+    uint64_t value = 1;
+    if ( _readyCount ) {
+        _eventSignalled = ( sizeof( value ) == write( _eventFd, &value, sizeof( value ) ) );
+    } else {
+        _eventSignalled = ( sizeof( value ) != read( _eventFd, &value, sizeof( value ) ) );
+    }
+#endif
+}
+
+//Wake consumers of grown output and producers of drained input
+void Pipeline::markNeighbours( uint8_t i, uint16_t inBefore, uint16_t outBefore ) {
+    ByteArray* input  = _pipes[i]->getInputBuffer();
+    ByteArray* output = _pipes[i]->getOutputBuffer();
+    bool gained = output && ( output->count() > outBefore );
+    bool freed  = input  && ( input->count()  < inBefore );
+    if ( !gained && !freed ) {
+        return;
+    }
+    for ( uint8_t k = 0; k < _pipes.size(); ++k ) {
+        if ( ( gained && ( _pipes[k]->getInputBuffer()  == output ) ) ||
+             ( freed  && ( _pipes[k]->getOutputBuffer() == input  ) ) ) {
+            setReady( k, true );
+        }
+    }
+}
+
+StatusCode Pipeline::processReady( void ) {
+
+    syncReady();
+    _faultyPipe = 0;
+
+    StatusCode status;
+    StatusCode failure = StatusCode::OK;
+
+    for ( uint8_t i = 0; _readyCount && i < _pipes.size(); ++i ) {
+        if ( !_ready[i] ) {
+            continue;
+        }
+        if ( !hasCredits( i ) ) {       //woken again when its output drains
+            setReady( i, false );
+            continue;
+        }
+
+        ByteArray* input     = _pipes[i]->getInputBuffer();
+        ByteArray* output    = _pipes[i]->getOutputBuffer();
+        uint16_t   inBefore  = input  ? input->count()  : 0;
+        uint16_t   outBefore = output ? output->count() : 0;
+
+        status = runPipe( i );
+
+        switch ( status ) {
+        case StatusCode::OK:            //wants more time
+        case StatusCode::REPEAT:
+            break;
+
+        case StatusCode::NEXT:          //one pass done, ready again while input is left
+            if ( !input || !input->count() ) {
+                setReady( i, false );
+            }
+            break;
+
+        case StatusCode::PENDING:       //needs more input
+            setReady( i, false );
+            break;
+
+        default:                        //PARTIAL, ERROR
+            setReady( i, false );
+            failure     = status;
+            _faultyPipe = i + 1;        //Count pipes from 1
+            if ( _ErrorHandler ) {
+                _ErrorHandler( this, status );
+            }
+            break;
+        }
+
+        markNeighbours( i, inBefore, outBefore );
+    }
+
+    updateEvent();
+
+    if ( StatusCode::OK != failure ) {
+        return failure;
+    }
+    return _readyCount ? StatusCode::OK : StatusCode::PENDING;
+}
+
+bool Pipeline::isIdle( void ) {
+    syncReady();
+    return 0 == _readyCount;
+}
+
+//eventfd for epoll/poll, created on first use
+int Pipeline::eventFd( void ) {
+#if defined( __linux__ )
+    if ( _eventFd < 0 ) {
+        _eventFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+        _eventSignalled = false;
+        syncReady();
+        updateEvent();
+    }
+    return _eventFd;
+#else
+    return -1;
+#endif
+}
+
+
+/* Profiling */
+
+//Every pipe call goes through here, profiling and tracing cost two clock reads
+StatusCode Pipeline::runPipe( uint8_t i, BatchBudget* pBudget ) {
+#if PIPELINE_PROFILING || PIPELINE_TRACING
+#if PIPELINE_PROFILING
+    bool profile = _profiling;
+#else
+    bool profile = false;
+#endif
+#if PIPELINE_TRACING
+    bool trace   = PipelineTrace::isEnabled();
+#else
+    bool trace   = false;
+#endif
+    if ( profile || trace ) {
+        ByteArray* input     = _pipes[i]->getInputBuffer();
+        ByteArray* output    = _pipes[i]->getOutputBuffer();
+        uint16_t   inBefore  = input  ? input->count()  : 0;
+        uint16_t   outBefore = output ? output->count() : 0;
+
+        uint64_t   t0        = pipelineNow();
+        StatusCode status    = pBudget ? _pipes[i]->processBatch( pBudget ) : _pipes[i]->process();
+        uint64_t   t1        = pipelineNow();
+
+        uint16_t   bytesIn   = ( input  && ( input->count()  < inBefore  ) ) ? inBefore - input->count()   : 0;
+        uint16_t   bytesOut  = ( output && ( output->count() > outBefore ) ) ? output->count() - outBefore : 0;
+
+#if PIPELINE_PROFILING
+        if ( profile ) {
+            if ( _stats.size() < _pipes.size() ) {
+                _stats.resize( _pipes.size() );
+            }
+            PipeStats& stats = _stats[i];
+            ++stats.calls;
+            if ( (uint8_t)status < 6 ) {
+                ++stats.statusCount[(uint8_t)status];
+            }
+            stats.bytesIn  += bytesIn;
+            stats.bytesOut += bytesOut;
+            stats.latency.record( t1 - t0 );
+        }
+#endif
+#if PIPELINE_TRACING
+        if ( trace ) {
+            PipelineTrace::process( _name, i + 1, t0, t1 - t0, (uint8_t)status, bytesIn, bytesOut );
+        }
+#endif
+        return status;
+    }
+#endif
+    return pBudget ? _pipes[i]->processBatch( pBudget ) : _pipes[i]->process();
+}
+
+void Pipeline::setProfiling( bool enable ) {
+#if PIPELINE_PROFILING
+    _profiling = enable;
+#else
+    (void)enable;
+#endif
+}
+
+bool Pipeline::getProfiling( void ) const {
+#if PIPELINE_PROFILING
+    return _profiling;
+#else
+    return false;
+#endif
+}
+
+//Count pipes from 1, false if there is nothing to copy
+bool Pipeline::getPipeStats( uint8_t PipeIndex, PipeStats* pStats ) const {
+#if PIPELINE_PROFILING
+    if ( pStats && PipeIndex > 0 && PipeIndex <= _pipes.size() ) {
+        if ( PipeIndex <= _stats.size() ) {
+            *pStats = _stats[PipeIndex-1];
+        } else {
+            pStats->clear();
+        }
+        return true;
+    }
+#else
+    (void)PipeIndex;
+    (void)pStats;
+#endif
+    return false;
+}
+
+void Pipeline::resetProfile( void ) {
+#if PIPELINE_PROFILING
+    for ( auto& stats : _stats ) {
+        stats.clear();
+    }
+#endif
+}
+
+
 /* Other utility functions */
 
+//Name in traces, kept by pointer
+void Pipeline::setName( const char* name ) {
+    _name = name;
+}
+
+const char* Pipeline::getName( void ) const {
+    return _name;
+}
+
 uint16_t Pipeline::getDefaultBufferSize() const {
     return _defaultBufferSize;
 }
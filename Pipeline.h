@@ -15,6 +15,9 @@
 #define _PIPELINE_H_
 
 #include "Pipe.h"
+#include "BufferPool.h"
+#include "PipeProfile.h"
+#include "PipelineTrace.h"
 
 #include <vector>
 
@@ -40,6 +43,7 @@ public:
 
     uint8_t    AddBuffer( int        BufferSize = -1 ); //every buffer can be added only once
     uint8_t    AddBuffer( ByteArray* pByteArray );      //they will get unique uint8_t ID
+    uint8_t    AddBuffer( BufferPool* pPool );          //back to the pool by the destructor
 
     StatusCode AddProcessor(    Pipe::ProcessorFunc processor,
                                 uint16_t            outputBufferSize = 0 );
@@ -53,6 +57,14 @@ public:
     StatusCode AddProcessor(    ByteArray*          inputBuffer,
                                 Pipe::ProcessorFunc processor,
                                 ByteArray*          outputBuffer );
+    StatusCode AddProcessor(    ByteArray*          inputBuffer,
+                                Pipe::ProcessorCtxFunc processor,
+                                void*               context,
+                                ByteArray*          outputBuffer );
+    StatusCode AddProcessor(    ByteArray*          inputBuffer,
+                                Pipe::BatchProcessorFunc processor,
+                                ByteArray*          outputBuffer );
+    StatusCode AddProcessor(    Pipe*               pPipe );   //takes ownership
 
     ByteArray* getFrontEnd() const;                         //first pipe input
     ByteArray* getBackEnd() const;                          //last pipe output
@@ -69,9 +81,27 @@ public:
     StatusCode Sink( uint8_t PipeIndex, char c );
     StatusCode Sink( uint8_t PipeIndex, const char* cstring );
     StatusCode Sink( uint8_t PipeIndex, ByteArray* pByteArray );
+    StatusCode Sink( uint8_t PipeIndex, const uint8_t* data, uint16_t size,
+                     uint16_t* pAccepted = nullptr );       //PARTIAL: only *pAccepted fit, maybe 0
+    StatusCode SinkFromFd( uint8_t PipeIndex, int fd,       //one read() into the free space,
+                           uint16_t* pRead = nullptr );     //NEXT: end of stream
 
     StatusCode processStep( uint8_t i );
     StatusCode processAll( void );
+    StatusCode processBatch( uint16_t maxItems, uint16_t maxBytes = 0xFFFF );
+
+    //credits: a pipe runs only with minCredits free bytes in its output, default 0: off
+    void       setMinCredits( uint8_t PipeIndex, uint16_t credits );
+    uint16_t   getCredits( uint8_t PipeIndex ) const;
+
+    //readiness driven alternative to processAll()
+    StatusCode processReady( void );                        //OK: more is ready, PENDING: idle
+    void       markReady( uint8_t PipeIndex );              //input changed from outside
+    bool       isIdle( void );
+    int        eventFd( void );                             //readable while not idle, -1 if n/a
+
+    void       setName( const char* name );                 //for traces, kept by pointer
+    const char* getName( void ) const;
 
     uint16_t   getDefaultBufferSize() const;
 
@@ -84,6 +114,12 @@ public:
     void       swapIO( uint8_t PipeIndex );                 //swap buffers of pipe
     void       swapBuffers( uint16_t x, uint16_t y );       //swap buffers in _buffers
 
+    //per pipe counters, compiled out with PIPELINE_PROFILING 0
+    void       setProfiling( bool enable );                 //off by default
+    bool       getProfiling( void ) const;
+    bool       getPipeStats( uint8_t PipeIndex, PipeStats* pStats ) const;  //snapshot
+    void       resetProfile( void );
+
     void       setErrorHandler( void (*ErrorHandler)( Pipeline* pPipeline, StatusCode ErrorCode ) );
 
 private:
@@ -91,10 +127,32 @@ private:
     uint8_t     _faultyPipe         = 0;
     uint8_t     _pipeOffset         = 0;
     uint16_t    _defaultBufferSize  = 128;
+    const char* _name               = "Pipeline";
     void      (*_ErrorHandler)( Pipeline* pPipeline, StatusCode ErrorCode ) = nullptr;
 
+    BufferPool* _pool               = nullptr;
     std::vector<ByteArray*>         _buffers;
     std::vector<Pipe*>              _pipes;
+
+    std::vector<uint8_t>            _ready;                 //per pipe, new pipes start ready
+    uint8_t     _readyCount         = 0;
+    int         _eventFd            = -1;
+    bool        _eventSignalled     = false;
+
+    void        syncReady( void );
+    void        setReady( uint8_t i, bool ready );
+    void        markNeighbours( uint8_t i, uint16_t inBefore, uint16_t outBefore );
+    void        updateEvent( void );
+
+    std::vector<uint16_t>           _minCredits;            //per pipe, empty: all 0, off
+    bool        hasCredits( uint8_t i );
+
+    StatusCode  runPipe( uint8_t i, BatchBudget* pBudget = nullptr );
+
+#if PIPELINE_PROFILING
+    bool                            _profiling = false;
+    std::vector<PipeStats>          _stats;
+#endif
 };
 
 #endif // _PIPELINE_H_
@@ -0,0 +1,341 @@
+/**
+ * @file    PipelineGraph.cpp
+ *
+ * @brief   Implementation of the PipelineGraph class
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+
+#include "PipelineGraph.h"
+
+#include <cstring>
+
+
+//Constructor with default buffer size
+PipelineGraph::PipelineGraph( uint16_t buffersize ) :
+    _defaultBufferSize( buffersize ) {
+}
+
+//Destructor, only buffers made by AddBuffer( int ) are deleted
+PipelineGraph::~PipelineGraph() {
+    for ( auto& buffer : _buffers ) {
+        if ( buffer.owned ) {
+            delete buffer.array;
+        }
+    }
+}
+
+
+/* Setup */
+
+uint8_t PipelineGraph::AddBuffer( int BufferSize ) {
+    uint16_t size = ( BufferSize < 0 ) ? _defaultBufferSize : (uint16_t)BufferSize;
+    _buffers.push_back( { size ? new ByteArray( size ) : nullptr, true, -1, {}, {} } );
+    _built = false;
+    return _buffers.size() - 1;
+}
+
+uint8_t PipelineGraph::AddBuffer( ByteArray* pByteArray ) {
+    _buffers.push_back( { pByteArray, false, -1, {}, {} } );
+    _built = false;
+    return _buffers.size() - 1;
+}
+
+//Count nodes from 1, 0 on bad buffer IDs
+uint8_t PipelineGraph::AddNode(
+    NodeFunc processor,
+    const uint8_t* inputIDs,  uint8_t inputCount,
+    const uint8_t* outputIDs, uint8_t outputCount,
+    void* context ) {
+
+    if ( !processor || _nodes.size() >= 255 ) {
+        return 0;
+    }
+    Node node = { processor, nullptr, context, {}, {}, {}, {}, {}, {} };
+    for ( uint8_t i = 0; i < inputCount; ++i ) {
+        if ( inputIDs[i] >= _buffers.size() ) {
+            return 0;
+        }
+        node.inputs.push_back( inputIDs[i] );
+    }
+    for ( uint8_t i = 0; i < outputCount; ++i ) {
+        if ( outputIDs[i] >= _buffers.size() ) {
+            return 0;
+        }
+        node.outputs.push_back( outputIDs[i] );
+    }
+    _nodes.push_back( node );
+    _built = false;
+    return _nodes.size();
+}
+
+uint8_t PipelineGraph::AddNode(
+    uint8_t inputBufferID, Pipe::ProcessorFunc processor, uint8_t outputBufferID ) {
+
+    if ( !processor || _nodes.size() >= 255 ||
+         inputBufferID >= _buffers.size() || outputBufferID >= _buffers.size() ) {
+        return 0;
+    }
+    _nodes.push_back( { nullptr, processor, nullptr, { inputBufferID }, { outputBufferID }, {}, {}, {}, {} } );
+    _built = false;
+    return _nodes.size();
+}
+
+
+/* Topological order */
+
+//Kahn: start with nodes no other node feeds, release consumers as their
+//producers are placed; nodes left over sit on a cycle
+StatusCode PipelineGraph::Build( void ) {
+
+    _built = false;
+    _order.clear();
+
+    for ( auto& buffer : _buffers ) {
+        buffer.producer = -1;
+        buffer.consumers.clear();
+        buffer.read.clear();
+    }
+
+    for ( uint8_t n = 0; n < _nodes.size(); ++n ) {
+        Node& node = _nodes[n];
+        node.slots.clear();
+        node.inputArrays.clear();
+        node.outputArrays.clear();
+        node.views.clear();
+        node.views.reserve( node.inputs.size() );   //inputArrays point into it
+        for ( auto id : node.inputs ) {
+            node.slots.push_back( _buffers[id].consumers.size() );
+            _buffers[id].consumers.push_back( n );
+            node.inputArrays.push_back( _buffers[id].array );
+        }
+        for ( auto id : node.outputs ) {
+            if ( 0 <= _buffers[id].producer ) {
+                _faultyNode = n + 1;    //second producer
+                return StatusCode::ERROR;
+            }
+            _buffers[id].producer = n;
+            node.outputArrays.push_back( _buffers[id].array );
+        }
+    }
+
+    //shared buffers: read positions, and no consumer that moves the data
+    for ( auto& buffer : _buffers ) {
+        if ( 1 < buffer.consumers.size() ) {
+            buffer.read.assign( buffer.consumers.size(), 0 );
+            for ( auto consumer : buffer.consumers ) {
+                if ( _nodes[consumer].simple ) {
+                    _faultyNode = consumer + 1;
+                    return StatusCode::ERROR;
+                }
+            }
+        }
+    }
+
+    std::vector<uint8_t> indegree( _nodes.size(), 0 );
+    for ( uint8_t n = 0; n < _nodes.size(); ++n ) {
+        for ( auto id : _nodes[n].inputs ) {
+            if ( 0 <= _buffers[id].producer ) {
+                ++indegree[n];
+            }
+        }
+    }
+
+    for ( uint8_t n = 0; n < _nodes.size(); ++n ) {
+        if ( 0 == indegree[n] ) {
+            _order.push_back( n );
+        }
+    }
+    for ( size_t k = 0; k < _order.size(); ++k ) {
+        for ( auto id : _nodes[_order[k]].outputs ) {
+            for ( auto consumer : _buffers[id].consumers ) {
+                if ( 0 == --indegree[consumer] ) {
+                    _order.push_back( consumer );
+                }
+            }
+        }
+    }
+
+    if ( _order.size() != _nodes.size() ) {
+        for ( uint8_t n = 0; n < _nodes.size(); ++n ) {
+            if ( indegree[n] ) {
+                _faultyNode = n + 1;    //on a cycle
+                break;
+            }
+        }
+        _order.clear();
+        return StatusCode::ERROR;
+    }
+
+    _faultyNode = 0;
+    _built      = true;
+    return StatusCode::OK;
+}
+
+
+/* Processing */
+
+//Bytes of the buffer the consumer in slot did not read yet
+uint16_t PipelineGraph::unread( uint8_t bufferID, uint8_t slot ) const {
+    const Buffer& buffer = _buffers[bufferID];
+    if ( !buffer.array ) {
+        return 0;
+    }
+    return buffer.read.empty() ? buffer.array->count() : buffer.array->count() - buffer.read[slot];
+}
+
+//Unread data on an input, or a source
+bool PipelineGraph::isReady( const Node& node ) const {
+    if ( node.inputs.empty() ) {
+        return true;
+    }
+    for ( uint8_t i = 0; i < node.inputs.size(); ++i ) {
+        if ( unread( node.inputs[i], node.slots[i] ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+StatusCode PipelineGraph::run( Node& node ) {
+#if EXCEPTIONS_SUPPORTED
+    try {
+#endif
+        if ( node.simple ) {
+            return node.simple( node.inputArrays[0], node.outputArrays[0] );
+        }
+        return node.processor( node.inputArrays.data(),  node.inputArrays.size(),
+                               node.outputArrays.data(), node.outputArrays.size(),
+                               node.context );
+#if EXCEPTIONS_SUPPORTED
+    } catch (...) {
+        return StatusCode::ERROR;
+    }
+#endif
+}
+
+//A consumer of a shared buffer read length more, what all have read goes
+void PipelineGraph::consumed( uint8_t bufferID, uint8_t slot, uint16_t length ) {
+    Buffer& buffer = _buffers[bufferID];
+    buffer.read[slot] += length;
+    uint16_t done = buffer.read[0];
+    for ( auto position : buffer.read ) {
+        if ( position < done ) {
+            done = position;
+        }
+    }
+    if ( done ) {
+        uint8_t* data = buffer.array->data();
+        std::memmove( data, data + done, buffer.array->count() - done );
+        buffer.array->update_count( buffer.array->count() - done );
+        for ( auto& position : buffer.read ) {
+            position -= done;
+        }
+    }
+}
+
+StatusCode PipelineGraph::processAll( void ) {
+
+    if ( !_built && ( StatusCode::OK != Build() ) ) {
+        return StatusCode::ERROR;
+    }
+
+    bool       ran     = false;
+    StatusCode failure = StatusCode::OK;
+    _faultyNode        = 0;
+
+    for ( auto n : _order ) {
+        Node& node = _nodes[n];
+        if ( !isReady( node ) ) {
+            continue;
+        }
+
+        //shared inputs: a view from the read position of the node
+        node.views.clear();
+        for ( uint8_t i = 0; i < node.inputs.size(); ++i ) {
+            Buffer& buffer = _buffers[node.inputs[i]];
+            if ( !buffer.read.empty() && buffer.array ) {
+                uint16_t from = buffer.read[node.slots[i]];
+                uint16_t left = buffer.array->count() - from;
+                node.views.emplace_back( left, left, buffer.array->data() + from, false );
+                node.inputArrays[i] = &node.views.back();
+            }
+        }
+
+        StatusCode status = run( node );
+        ran = true;
+
+        switch ( status ) {
+        case StatusCode::REPEAT:        //consumes nothing of its shared inputs
+            continue;
+
+        case StatusCode::OK:
+        case StatusCode::NEXT:
+        case StatusCode::PENDING:       //waits on its own branch
+            break;
+
+        default:                        //PARTIAL, ERROR
+            if ( !_faultyNode ) {
+                _faultyNode = n + 1;    //Count nodes from 1
+                failure     = status;
+            }
+            if ( _ErrorHandler ) {
+                _ErrorHandler( this, status );
+            }
+            break;
+        }
+
+        //PENDING keeps what was not taken off the view, e.g. a partial frame
+        for ( uint8_t i = 0, v = 0; i < node.inputs.size(); ++i ) {
+            Buffer& buffer = _buffers[node.inputs[i]];
+            if ( !buffer.read.empty() && buffer.array ) {
+                const ByteArray& view = node.views[v++];
+                uint16_t length = view.size();
+                if ( StatusCode::PENDING == status ) {
+                    length = ( view.count() < view.size() ) ? view.size() - view.count() : 0;
+                }
+                consumed( node.inputs[i], node.slots[i], length );
+            }
+        }
+    }
+
+    if ( StatusCode::OK != failure ) {
+        return failure;
+    }
+    return ran ? StatusCode::OK : StatusCode::PENDING;
+}
+
+
+/* Other utility functions */
+
+ByteArray* PipelineGraph::getBuffer( uint8_t index ) const {
+    if ( index < _buffers.size() ) {
+        return _buffers[index].array;
+    }
+    return nullptr;
+}
+
+uint8_t PipelineGraph::getNodeCount( void ) const {
+    return _nodes.size();
+}
+
+uint8_t PipelineGraph::getBufferCount( void ) const {
+    return _buffers.size();
+}
+
+//Count nodes from 1, 0 if nothing failed
+uint8_t PipelineGraph::getFaultyNode( void ) const {
+    return _faultyNode;
+}
+
+void PipelineGraph::setErrorHandler( void (*ErrorHandler)( PipelineGraph* pGraph, StatusCode ErrorCode ) ) {
+    if ( ErrorHandler ) {
+        _ErrorHandler = ErrorHandler;
+    }
+}
@@ -0,0 +1,116 @@
+/**
+ * @file    PipelineGraph.h
+ *
+ * @brief   Declaration of PipelineGraph
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _PIPELINEGRAPH_H_
+#define _PIPELINEGRAPH_H_
+
+#include "Pipe.h"
+
+#include <vector>
+
+
+/*
+ * PipelineGraph is Pipeline as a directed acyclic graph: a node may read
+ * several buffers (fan-in) and write several buffers, and a buffer may be
+ * read by several nodes (fan-out). Every buffer has one producer.
+ *
+ * A buffer with one consumer works as in Pipeline, the consumer takes the
+ * data out. A buffer with more consumers is shared without copying: every
+ * consumer has its own read position and gets a view of the data from it,
+ * which it only reads. A consumer returning PENDING has consumed only what
+ * it took off the count of its view (never moving the data), the rest, e.g.
+ * a partial frame, is shown again with more data behind it; REPEAT consumes
+ * nothing, any other status all of the view. Once every consumer has read
+ * past some data the graph drops it from the front of the buffer. The
+ * producer may append meanwhile. A 1 in 1 out ProcessorFunc moves the data
+ * of its input, so Build() rejects one on a shared buffer.
+ *
+ * Build() orders the nodes topologically (Kahn) and rejects cycles.
+ * processAll() walks that order once and runs only the nodes that have data
+ * on some input (sources, nodes without inputs, always run). A PENDING or
+ * failing node stops its own branch only.
+ */
+
+class PipelineGraph {
+
+public:
+    //multi buffer processor, buffers in the order they were given to AddNode
+    using NodeFunc = StatusCode (*)( ByteArray** inputs,  uint8_t inputCount,
+                                     ByteArray** outputs, uint8_t outputCount,
+                                     void* context );
+
+    PipelineGraph( uint16_t buffersize = 128 );
+    ~PipelineGraph();
+
+    uint8_t    AddBuffer( int        BufferSize = -1 ); //buffer ID from 0
+    uint8_t    AddBuffer( ByteArray* pByteArray );      //not deleted by the graph
+
+    uint8_t    AddNode( NodeFunc            processor,  //NodeIndex from 1, 0 on error
+                        const uint8_t*      inputIDs,
+                        uint8_t             inputCount,
+                        const uint8_t*      outputIDs,
+                        uint8_t             outputCount,
+                        void*               context = nullptr );
+    uint8_t    AddNode( uint8_t             inputBufferID,
+                        Pipe::ProcessorFunc processor,
+                        uint8_t             outputBufferID );
+
+    StatusCode Build( void );                           //ERROR on a cycle, a second producer
+                                                        //or a ProcessorFunc on a shared buffer
+    StatusCode processAll( void );                      //OK: something ran, PENDING: idle
+
+    ByteArray* getBuffer( uint8_t index ) const;
+    uint8_t    getNodeCount( void ) const;
+    uint8_t    getBufferCount( void ) const;
+    uint8_t    getFaultyNode( void ) const;
+
+    void       setErrorHandler( void (*ErrorHandler)( PipelineGraph* pGraph, StatusCode ErrorCode ) );
+
+private:
+
+    struct Buffer {
+        ByteArray*              array;
+        bool                    owned;
+        int16_t                 producer;       //node, -1 if fed from outside
+        std::vector<uint8_t>    consumers;      //nodes
+        std::vector<uint16_t>   read;           //position of each consumer, shared buffers only
+    };
+
+    struct Node {
+        NodeFunc                processor;
+        Pipe::ProcessorFunc     simple;         //1 in, 1 out shortcut
+        void*                   context;
+        std::vector<uint8_t>    inputs;         //buffer IDs
+        std::vector<uint8_t>    outputs;
+        std::vector<uint8_t>    slots;          //consumer index of the node in each input
+        std::vector<ByteArray*> inputArrays;
+        std::vector<ByteArray*> outputArrays;
+        std::vector<ByteArray>  views;          //of shared inputs from the read position
+    };
+
+    uint16_t   unread( uint8_t bufferID, uint8_t slot ) const;
+    bool       isReady( const Node& node ) const;
+    StatusCode run( Node& node );
+    void       consumed( uint8_t bufferID, uint8_t slot, uint16_t length );
+
+    uint16_t                _defaultBufferSize;
+    uint8_t                 _faultyNode     = 0;
+    bool                    _built          = false;
+    void                  (*_ErrorHandler)( PipelineGraph* pGraph, StatusCode ErrorCode ) = nullptr;
+
+    std::vector<Buffer>     _buffers;
+    std::vector<Node>       _nodes;
+    std::vector<uint8_t>    _order;         //topological
+};
+
+#endif // _PIPELINEGRAPH_H_
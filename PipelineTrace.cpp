@@ -0,0 +1,171 @@
+/**
+ * @file    PipelineTrace.cpp
+ *
+ * @brief   Implementation of PipelineTrace
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include "PipelineTrace.h"
+#include "PipeProfile.h"        //pipelineNow
+
+
+std::atomic<bool>                           PipelineTrace::_enabled( false );
+std::atomic<PipelineTrace::ThreadBuffer*>   PipelineTrace::_threads( nullptr );
+std::atomic<uint32_t>                       PipelineTrace::_nextTid( 1 );
+
+//gives the buffer of the thread back when the thread ends
+struct TraceThreadExit {
+    PipelineTrace::ThreadBuffer*    buffer = nullptr;
+    ~TraceThreadExit() {
+        if ( buffer ) {
+            buffer->inUse.store( false, std::memory_order_release );
+        }
+    }
+};
+
+static thread_local TraceThreadExit         tlsBuffer;
+
+static const char* const statusNames[] = { "OK", "PENDING", "PARTIAL", "ERROR", "REPEAT", "NEXT" };
+
+
+/* Recording */
+
+void PipelineTrace::enable( bool on ) {
+    _enabled.store( on, std::memory_order_relaxed );
+}
+
+//Buffer of the calling thread: one left by an ended thread, or else
+//made and published on first use
+PipelineTrace::ThreadBuffer* PipelineTrace::local( void ) {
+    ThreadBuffer* buffer = tlsBuffer.buffer;
+    if ( buffer ) {
+        return buffer;
+    }
+    for ( buffer = _threads.load( std::memory_order_acquire ); buffer; buffer = buffer->next ) {
+        bool expected = false;
+        if ( buffer->inUse.compare_exchange_strong( expected, true, std::memory_order_acq_rel ) ) {
+            tlsBuffer.buffer = buffer;
+            return buffer;
+        }
+    }
+    buffer = new ThreadBuffer;
+    buffer->tid = _nextTid.fetch_add( 1, std::memory_order_relaxed );
+    buffer->count.store( 0, std::memory_order_relaxed );
+    buffer->dropped.store( 0, std::memory_order_relaxed );
+    buffer->inUse.store( true, std::memory_order_relaxed );
+    buffer->next = _threads.load( std::memory_order_relaxed );
+    while ( !_threads.compare_exchange_weak( buffer->next, buffer,
+                std::memory_order_release, std::memory_order_relaxed ) ) {
+    }
+    tlsBuffer.buffer = buffer;
+    return buffer;
+}
+
+//Single writer per buffer: fill the slot, then publish the count
+void PipelineTrace::record( const Event& event ) {
+    ThreadBuffer* buffer = local();
+    uint32_t count = buffer->count.load( std::memory_order_relaxed );
+    if ( count >= PIPELINE_TRACE_EVENTS ) {
+        buffer->dropped.fetch_add( 1, std::memory_order_relaxed );
+        return;
+    }
+    buffer->events[count] = event;
+    buffer->count.store( count + 1, std::memory_order_release );
+}
+
+void PipelineTrace::process( const char* name, uint8_t pipe, uint64_t start, uint64_t duration,
+                             uint8_t status, uint16_t bytesIn, uint16_t bytesOut ) {
+    record( { start, duration, name, bytesIn, bytesOut, pipe, status, PROCESS } );
+}
+
+void PipelineTrace::handoff( const char* name, uint8_t pipe, uint16_t bytes ) {
+    record( { pipelineNow(), 0, name, 0, bytes, pipe, 0, HANDOFF } );
+}
+
+
+/* Output */
+
+//JSON string without the characters that would break it, "name #pipe"
+static void writeName( FILE* file, const char* name, int pipe ) {
+    fputc( '"', file );
+    for ( const char* c = name ? name : "Pipeline"; *c; ++c ) {
+        if ( '"' == *c || '\\' == *c ) {
+            fputc( '\\', file );
+        }
+        if ( (uint8_t)*c >= ' ' ) {
+            fputc( *c, file );
+        }
+    }
+    if ( 0 < pipe ) {
+        fprintf( file, " #%d", pipe );
+    }
+    fputc( '"', file );
+}
+
+bool PipelineTrace::dump( const char* path ) {
+    FILE* file = fopen( path, "w" );
+    if ( !file ) {
+        return false;
+    }
+    bool ok = dump( file );
+    return ( 0 == fclose( file ) ) && ok;
+}
+
+//Trace Event Format: X events for process(), i events for handoffs,
+//timestamps in microseconds
+bool PipelineTrace::dump( FILE* file ) {
+    bool first = true;
+    fprintf( file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" );
+    for ( ThreadBuffer* buffer = _threads.load( std::memory_order_acquire );
+          buffer; buffer = buffer->next ) {
+        fprintf( file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                       "\"args\":{\"name\":\"thread %u\"}}",
+                 first ? "" : ",", buffer->tid, buffer->tid );
+        first = false;
+        uint32_t count = buffer->count.load( std::memory_order_acquire );
+        for ( uint32_t k = 0; k < count; ++k ) {
+            const Event& event = buffer->events[k];
+            fprintf( file, ",\n{\"name\":" );
+            if ( PROCESS == event.kind ) {
+                writeName( file, event.name, event.pipe );
+                fprintf( file, ",\"cat\":\"pipe\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                               "\"pid\":1,\"tid\":%u,\"args\":{\"pipe\":%u,\"status\":\"%s\","
+                               "\"in\":%u,\"out\":%u}}",
+                         event.start / 1000.0, event.duration / 1000.0, buffer->tid,
+                         event.pipe, ( event.status < 6 ) ? statusNames[event.status] : "?",
+                         event.bytesIn, event.bytesOut );
+            } else {
+                fprintf( file, "\"handoff\",\"cat\":\"buffer\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,"
+                               "\"pid\":1,\"tid\":%u,\"args\":{\"from\":",
+                         event.start / 1000.0, buffer->tid );
+                writeName( file, event.name, 0 );
+                fprintf( file, ",\"pipe\":%u,\"bytes\":%u}}", event.pipe, event.bytesOut );
+            }
+        }
+    }
+    fprintf( file, "\n]}\n" );
+    return !ferror( file );
+}
+
+void PipelineTrace::clear( void ) {
+    for ( ThreadBuffer* buffer = _threads.load( std::memory_order_acquire );
+          buffer; buffer = buffer->next ) {
+        buffer->count.store( 0, std::memory_order_relaxed );
+        buffer->dropped.store( 0, std::memory_order_relaxed );
+    }
+}
+
+uint32_t PipelineTrace::getDropped( void ) {
+    uint32_t dropped = 0;
+    for ( ThreadBuffer* buffer = _threads.load( std::memory_order_acquire );
+          buffer; buffer = buffer->next ) {
+        dropped += buffer->dropped.load( std::memory_order_relaxed );
+    }
+    return dropped;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file    PipelineTrace.h
+ *
+ * @brief   Declaration of PipelineTrace
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _PIPELINETRACE_H_
+#define _PIPELINETRACE_H_
+
+
+//0 compiles the tracing out of Pipeline, 1 makes it switchable at runtime,
+//then PipelineTrace.cpp has to be linked
+#ifndef PIPELINE_TRACING
+#define PIPELINE_TRACING 0
+#endif
+
+//events every thread can record before it starts dropping them
+#ifndef PIPELINE_TRACE_EVENTS
+#define PIPELINE_TRACE_EVENTS 16384
+#endif
+
+
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/*
+ * PipelineTrace records what pipes did and when, to look at it in
+ * chrome://tracing or ui.perfetto.dev. Every thread writes into its own
+ * fixed buffer, allocated on its first event and chained into a lock free
+ * list, so recording takes no lock and no allocation. A full buffer drops
+ * further events and counts them. The buffer of a thread that ended, with
+ * its events, is taken over by the next thread that records, so threads
+ * coming and going cost no more buffers than ever ran at once. Names are
+ * kept by pointer and must live until dump(). Recording is off until
+ * enable( true ), and compiled out of Pipeline unless PIPELINE_TRACING.
+ */
+
+class PipelineTrace {
+
+public:
+    enum Kind : uint8_t {
+        PROCESS,        //one Pipe::process() call, with duration
+        HANDOFF         //bytes moved between buffers, an instant
+    };
+
+    struct Event {
+        uint64_t        start;          //pipelineNow() ns
+        uint64_t        duration;       //ns, 0 for instants
+        const char*     name;           //pipeline or other owner
+        uint16_t        bytesIn;
+        uint16_t        bytesOut;
+        uint8_t         pipe;           //count pipes from 1
+        uint8_t         status;         //StatusCode
+        uint8_t         kind;
+    };
+
+    static void     enable( bool on );
+    static bool     isEnabled( void ) {
+        return _enabled.load( std::memory_order_relaxed );
+    }
+
+    static void     process( const char* name, uint8_t pipe, uint64_t start, uint64_t duration,
+                             uint8_t status, uint16_t bytesIn, uint16_t bytesOut );
+    static void     handoff( const char* name, uint8_t pipe, uint16_t bytes );
+
+    static bool     dump( const char* path );           //Chrome Trace Event JSON
+    static bool     dump( FILE* file );
+    static void     clear( void );                      //only while nothing records
+    static uint32_t getDropped( void );
+
+private:
+    struct ThreadBuffer {
+        uint32_t                tid;
+        std::atomic<uint32_t>   count;
+        std::atomic<uint32_t>   dropped;
+        std::atomic<bool>       inUse;          //a live thread records into it
+        ThreadBuffer*           next;
+        Event                   events[PIPELINE_TRACE_EVENTS];
+    };
+
+    friend struct TraceThreadExit;
+
+    static ThreadBuffer*    local( void );
+    static void             record( const Event& event );
+
+    static std::atomic<bool>            _enabled;
+    static std::atomic<ThreadBuffer*>   _threads;
+    static std::atomic<uint32_t>        _nextTid;
+};
+
+#endif // _PIPELINETRACE_H_
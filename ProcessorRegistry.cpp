@@ -0,0 +1,261 @@
+/**
+ * @file    ProcessorRegistry.cpp
+ *
+ * @brief   Implementation of the ProcessorRegistry class
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include "ProcessorRegistry.h"
+
+#include <cstring>
+
+
+ProcessorRegistry::ProcessorRegistry() :
+    _entries( {} ) {
+}
+
+
+/* Registration */
+
+bool ProcessorRegistry::Register( const char* name, Pipe::ProcessorFunc processor ) {
+    if ( !name || !*name || !processor || contains( name ) ) {
+        return false;
+    }
+    _entries.insert( name, { processor, nullptr, nullptr } );
+    return true;
+}
+
+bool ProcessorRegistry::Register( const char* name, Factory factory, Validator validator ) {
+    if ( !name || !*name || !factory || contains( name ) ) {
+        return false;
+    }
+    _entries.insert( name, { nullptr, factory, validator } );
+    return true;
+}
+
+bool ProcessorRegistry::contains( const char* name ) const {
+    return name && _entries.contains( name );
+}
+
+
+/* Checking */
+
+bool ProcessorRegistry::fail( const std::string& error ) {
+    _error = error;
+    return false;
+}
+
+//Decimal digits only, 1..max, or 0..max for credits
+bool ProcessorRegistry::number( const char* key, const uint8_t* text, uint32_t max, uint32_t* pValue ) {
+    uint32_t value = 0;
+    const uint8_t* p = text;
+    for ( ; *p; ++p ) {
+        if ( *p < '0' || *p > '9' || value > max ) {
+            break;
+        }
+        value = value * 10 + ( *p - '0' );
+    }
+    if ( *p || p == text || value > max ) {
+        return fail( std::string( key ) + ": not a number up to " + std::to_string( max ) );
+    }
+    *pValue = value;
+    return true;
+}
+
+//pipe.N or pipe.N.suffix, N from 1 without leading zeros, 0 if not such a key
+static uint16_t pipeNumber( const char* key, const char** pSuffix ) {
+    if ( strncmp( key, "pipe.", 5 ) ) {
+        return 0;
+    }
+    const char* p = key + 5;
+    uint16_t n = 0;
+    if ( '0' == *p ) {
+        return 0;
+    }
+    for ( ; '0' <= *p && *p <= '9' && n < 1000; ++p ) {
+        n = n * 10 + ( *p - '0' );
+    }
+    if ( *p && '.' != *p ) {
+        return 0;
+    }
+    *pSuffix = *p ? p + 1 : p;
+    return n;
+}
+
+//Everything Build() needs, nothing created yet
+bool ProcessorRegistry::check( const Dictionary& config, std::deque<Stage>& stages, uint16_t* pInput ) {
+    uint32_t size   = 128;
+    uint32_t input  = 0;
+    uint16_t count  = 0;
+    const uint8_t* text;
+    if ( ( text = config.contains( "buffer" ) ) && !number( "buffer", text, 0xFFFF, &size ) ) {
+        return false;
+    }
+    if ( ( text = config.contains( "input" ) ) && !number( "input", text, 0xFFFF, &input ) ) {
+        return false;
+    }
+    if ( !size || ( text && !input ) ) {
+        return fail( "buffer and input can not be 0" );
+    }
+    *pInput = input ? input : size;
+
+    //the pipes and their names
+    for ( uint16_t k = 0; k < config.keys(); ++k ) {
+        const char* key = (const char*)config.key( k );
+        const char* suffix;
+        uint16_t    n = pipeNumber( key, &suffix );
+        if ( !n ) {
+            if ( strcmp( key, "name" ) && strcmp( key, "buffer" ) && strcmp( key, "input" ) ) {
+                return fail( std::string( key ) + ": unknown key" );
+            }
+            continue;
+        }
+        if ( n > 255 ) {
+            return fail( std::string( key ) + ": more than 255 pipes" );
+        }
+        if ( !*suffix && n > count ) {
+            count = n;
+        }
+    }
+    if ( !count ) {
+        return fail( "no pipes" );
+    }
+
+    //sizes and parameters of each pipe, key, 0, data, 0
+    std::vector<uint16_t> output( count + 1, size );
+    std::vector<uint16_t> credits( count + 1, 0 );
+    std::vector<bool>     hasCredits( count + 1, false );
+    std::vector<uint16_t> paramSize( count + 1, 0 );
+    for ( uint16_t k = 0; k < config.keys(); ++k ) {
+        const char* key = (const char*)config.key( k );
+        const char* suffix;
+        uint16_t    n = pipeNumber( key, &suffix );
+        if ( !n || !*suffix ) {
+            continue;
+        }
+        if ( n > count ) {
+            return fail( std::string( key ) + ": no pipe." + std::to_string( n ) );
+        }
+        uint32_t value;
+        if ( !strcmp( suffix, "output" ) ) {
+            if ( !number( key, config.data( k ), 0xFFFF, &value ) ) {
+                return false;
+            }
+            if ( !value ) {
+                return fail( std::string( key ) + ": can not be 0" );
+            }
+            output[n] = value;
+        } else if ( !strcmp( suffix, "credits" ) ) {
+            if ( !number( key, config.data( k ), 0xFFFF, &value ) ) {
+                return false;
+            }
+            credits[n]    = value;
+            hasCredits[n] = true;
+        } else {
+            paramSize[n] += strlen( suffix ) + strlen( (const char*)config.data( k ) ) + 2;
+        }
+    }
+
+    //the names, a Dictionary can not grow, so it is made to size
+    stages.clear();
+    for ( uint16_t n = 1; n <= count; ++n ) {
+        std::string key  = "pipe." + std::to_string( n );
+        const char* name = (const char*)config.contains( key.c_str() );
+        if ( !name ) {
+            return fail( key + ": missing" );
+        }
+        if ( !contains( name ) ) {
+            return fail( key + ": " + name + " is not registered" );
+        }
+        stages.push_back( { _entries.value( name ), output[n], credits[n], hasCredits[n],
+                            Dictionary( paramSize[n] ) } );
+    }
+    for ( uint16_t k = 0; k < config.keys(); ++k ) {
+        const char* key = (const char*)config.key( k );
+        const char* suffix;
+        uint16_t    n = pipeNumber( key, &suffix );
+        if ( n && *suffix && strcmp( suffix, "output" ) && strcmp( suffix, "credits" ) ) {
+            stages[n - 1].params.append( suffix, (const char*)config.data( k ) );
+        }
+    }
+
+    //a plain processor takes no parameters, the validator checks the rest
+    for ( uint16_t n = 1; n <= count; ++n ) {
+        const Stage& stage = stages[n - 1];
+        std::string  key   = "pipe." + std::to_string( n );
+        if ( stage.entry.processor && stage.params.keys() ) {
+            return fail( key + ": " + (const char*)stage.params.key( 0 ) + ": takes no parameters" );
+        }
+        if ( stage.entry.validator && !stage.entry.validator( stage.params ) ) {
+            return fail( key + ": bad parameters" );
+        }
+    }
+    return true;
+}
+
+
+/* Building */
+
+Pipeline* ProcessorRegistry::Build( const char* text ) {
+    size_t length = text ? strlen( text ) : 0;
+    if ( length >= 0xFFFF ) {
+        fail( "config too long" );
+        return nullptr;
+    }
+    //the records take no more than the text itself
+    Dictionary config( length + 1 );
+    uint16_t   line = 0;
+    if ( !config.parse( text, &line ) ) {
+        fail( "line " + std::to_string( line ) + ": not key : value or a repeated key" );
+        return nullptr;
+    }
+    return Build( config );
+}
+
+Pipeline* ProcessorRegistry::Build( const Dictionary& config ) {
+    std::deque<Stage> stages;
+    uint16_t input;
+    _error.clear();
+    if ( !check( config, stages, &input ) ) {
+        return nullptr;
+    }
+
+    Pipeline* pipeline = new Pipeline( input );
+    for ( size_t i = 0; i < stages.size(); ++i ) {
+        Stage&     stage = stages[i];
+        ByteArray* in    = pipeline->getBuffer( i );
+        uint8_t    id    = pipeline->AddBuffer( (int)stage.output );
+        ByteArray* out   = id ? pipeline->getBuffer( id ) : nullptr;
+        Pipe*      pipe  = nullptr;
+        if ( in && out ) {
+            pipe = stage.entry.factory ? stage.entry.factory( in, out, stage.params )
+                                       : new Pipe( in, stage.entry.processor, out );
+        }
+        if ( !pipe ) {
+            fail( "pipe." + std::to_string( i + 1 ) + ": could not be created" );
+            delete pipeline;
+            return nullptr;
+        }
+        pipeline->AddProcessor( pipe );
+        if ( stage.hasCredits ) {
+            pipeline->setMinCredits( i + 1, stage.credits );
+        }
+    }
+
+    const uint8_t* name = config.contains( "name" );
+    if ( name && *name ) {
+        _names.push_back( (const char*)name );
+        pipeline->setName( _names.back().c_str() );
+    }
+    return pipeline;
+}
+
+const char* ProcessorRegistry::getError( void ) const {
+    return _error.c_str();
+}
@@ -0,0 +1,94 @@
+/**
+ * @file    ProcessorRegistry.h
+ *
+ * @brief   Declaration of ProcessorRegistry
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _PROCESSORREGISTRY_H_
+#define _PROCESSORREGISTRY_H_
+
+
+#include "Pipeline.h"
+#include "Dictionary.h"
+#include "aMap.h"
+
+#include <deque>
+#include <vector>
+#include <string>
+
+
+/*
+ * ProcessorRegistry maps names to stages and builds Pipelines from a text
+ * in the Dictionary print() format, so a topology can change without a
+ * rebuild:
+ *
+ *      name            : uart      # for traces
+ *      buffer          : 128       # default buffer size
+ *      input           : 256       # front end size, default buffer
+ *      pipe.1          : cobs      # registered name, pipes count from 1
+ *      pipe.1.output   : 64        # output size, default buffer
+ *      pipe.1.credits  : 8         # setMinCredits()
+ *      pipe.1.key      : value     # anything else goes to the factory
+ *
+ * Every pipe reads the output of the one before. A plain ProcessorFunc
+ * takes no parameters, a Factory gets its pipe.N.* keys with the prefix
+ * removed and makes the Pipe, e.g. a derived one that owns its context.
+ * A Validator checks them.
+ *
+ * Build() checks the whole text first: unknown keys, gaps in the pipe
+ * numbers, bad sizes, unregistered names and parameters the validator
+ * rejects. Only then are buffers and pipes created, a factory that still
+ * fails takes the half built pipeline with it. On an error nullptr is
+ * returned and getError() tells why. The names given to setName() are
+ * kept by the registry, it must outlive the pipelines it built.
+ */
+
+class ProcessorRegistry {
+
+public:
+    using Factory   = Pipe* (*)( ByteArray* pInput, ByteArray* pOutput, const Dictionary& params );
+    using Validator = bool  (*)( const Dictionary& params );
+
+    ProcessorRegistry();
+
+    bool       Register( const char* name, Pipe::ProcessorFunc processor );                  //false if taken
+    bool       Register( const char* name, Factory factory, Validator validator = nullptr );
+    bool       contains( const char* name ) const;
+
+    Pipeline*  Build( const char* text );                   //nullptr on error
+    Pipeline*  Build( const Dictionary& config );
+    const char* getError( void ) const;
+
+private:
+
+    struct Entry {
+        Pipe::ProcessorFunc processor;
+        Factory             factory;
+        Validator           validator;
+    };
+
+    struct Stage {
+        Entry               entry;
+        uint16_t            output;         //buffer size
+        uint16_t            credits;
+        bool                hasCredits;
+        Dictionary          params;
+    };
+
+    bool       fail( const std::string& error );
+    bool       number( const char* key, const uint8_t* text, uint32_t max, uint32_t* pValue );
+    bool       check( const Dictionary& config, std::deque<Stage>& stages, uint16_t* pInput );
+
+    aMap<std::string, Entry>    _entries;
+    std::deque<std::string>     _names;         //given to Pipeline::setName()
+    std::string                 _error;
+};
+
+#endif // _PROCESSORREGISTRY_H_
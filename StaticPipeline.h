@@ -0,0 +1,165 @@
+/**
+ * @file    StaticPipeline.h
+ *
+ * @brief   Declaration of class template StaticPipeline
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _STATICPIPELINE_H_
+#define _STATICPIPELINE_H_
+
+#include "Pipe.h"
+
+#include <cstddef>
+#include <utility>          //std::index_sequence
+
+
+/*
+ * StaticPipeline is Pipeline for a topology fixed at compile time:
+ *
+ *  StaticPipeline<128, decode, filter, encode> pipeline;
+ *
+ * The stages are the usual Pipe::ProcessorFunc functions, but given as
+ * template arguments, so every call is direct and can be inlined; there is
+ * no vector of Pipes and no Pipe::process() in between. Stage i reads
+ * buffer i and writes buffer i + 1, all StageCount + 1 buffers of BufferSize
+ * bytes lie back to back in the object itself.
+ * processAll() keeps the StatusCode semantics of Pipeline::processAll().
+ */
+
+template < uint16_t BufferSize, Pipe::ProcessorFunc... Stages >
+
+class StaticPipeline {
+
+    static_assert( 0 < sizeof...( Stages ), "StaticPipeline needs at least one stage" );
+    static_assert( 0 < BufferSize, "StaticPipeline needs buffers" );
+
+public:
+    static constexpr uint8_t StageCount = sizeof...( Stages );
+
+    StaticPipeline() : StaticPipeline( std::make_index_sequence<StageCount + 1>() ) {}
+
+    StaticPipeline( const StaticPipeline& other ) = delete;
+    StaticPipeline& operator = ( const StaticPipeline& other ) = delete;
+
+    //first stage input
+    ByteArray* getFrontEnd() {
+        return &_buffers[0];
+    }
+
+    //last stage output
+    ByteArray* getBackEnd() {
+        return &_buffers[StageCount];
+    }
+
+    //buffer index, 0 is the front end
+    ByteArray* getBuffer( uint8_t index ) {
+        return ( index <= StageCount ) ? &_buffers[index] : nullptr;
+    }
+
+    //Count pipes from 1
+    StatusCode processStep( uint8_t i ) {
+        _faultyPipe = 0;
+        StatusCode status = step<0>( i - 1 );
+        if ( ( status != StatusCode::NEXT ) && ( status != StatusCode::OK ) ) {
+            _faultyPipe = i;
+        }
+        return status;
+    }
+
+    StatusCode processAll() {
+        uint8_t from = _pipeOffset;
+        _pipeOffset  = 0;
+        _faultyPipe  = 0;
+        return run<0>( from );
+    }
+
+    uint8_t getFaultyPipe() const {
+        return _faultyPipe;
+    }
+
+    uint8_t getPipeOffset() const {
+        return _pipeOffset;
+    }
+
+    uint8_t getPipeCount() const {
+        return StageCount;
+    }
+
+private:
+    static constexpr Pipe::ProcessorFunc _stages[] = { Stages... };
+
+    template < size_t... I >
+    StaticPipeline( std::index_sequence<I...> ) :
+        _buffers{ ByteArray( BufferSize, 0, _storage + I * BufferSize, false )... } {}
+
+    //stage I, direct call
+    template < uint8_t I >
+    StatusCode call() {
+#if EXCEPTIONS_SUPPORTED
+        try {
+            return _stages[I]( &_buffers[I], &_buffers[I + 1] );
+        } catch (...) {
+            return StatusCode::ERROR;
+        }
+#else
+        return _stages[I]( &_buffers[I], &_buffers[I + 1] );
+#endif
+    }
+
+    //stage i, unrolled into a chain of compares
+    template < uint8_t I >
+    StatusCode step( uint8_t i ) {
+        if constexpr ( I < StageCount ) {
+            return ( I == i ) ? call<I>() : step<I + 1>( i );
+        } else {
+            return StatusCode::ERROR;   //no such a pipe
+        }
+    }
+
+    //stages from..StageCount - 1, the whole chain is one inlined function
+    template < uint8_t I >
+    StatusCode run( uint8_t from ) {
+        if ( I >= from ) {
+            StatusCode status = call<I>();
+            if ( StatusCode::NEXT != status ) {
+                return stop( I, status );
+            }
+        }
+        if constexpr ( I + 1 < StageCount ) {
+            return run<I + 1>( from );
+        } else {
+            return StatusCode::NEXT;
+        }
+    }
+
+    //what processAll() does on a status other than NEXT
+    StatusCode stop( uint8_t i, StatusCode status ) {
+        switch ( status ) {
+        case StatusCode::OK:            //finish time quant, continue later with next
+            _pipeOffset = i + 1;
+            break;
+        case StatusCode::REPEAT:        //finish time quant, repeat later again
+            _pipeOffset = i;
+            break;
+        default:                        //PENDING, PARTIAL, ERROR
+            _faultyPipe = i + 1;        //Count pipes from 1
+            break;
+        }
+        return status;
+    }
+
+    uint8_t     _faultyPipe = 0;
+    uint8_t     _pipeOffset = 0;
+
+    alignas( 64 ) uint8_t   _storage[( StageCount + 1 ) * BufferSize];
+    ByteArray               _buffers[StageCount + 1];
+};
+
+#endif // _STATICPIPELINE_H_
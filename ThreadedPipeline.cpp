@@ -0,0 +1,203 @@
+/**
+ * @file    ThreadedPipeline.cpp
+ *
+ * @brief   Implementation of the ThreadedPipeline class
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#if defined( __linux__ )
+
+#include "ThreadedPipeline.h"
+
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+
+
+//how long a parked stage sleeps before it looks at _running again
+#define STAGE_POLL_MS 20
+
+
+//Constructor, edgeSize is the size of every ring between the stages
+ThreadedPipeline::ThreadedPipeline( uint16_t edgeSize ) :
+    _edgeSize( edgeSize ), _running( false ),
+    _faultyStage( 0 ), _lastError( StatusCode::OK ) {
+    //input edge
+    _edges.push_back( new WaitableCircularBuffer( _edgeSize ) );
+}
+
+//Destructor, stages are owned by the caller
+ThreadedPipeline::~ThreadedPipeline() {
+    Stop();
+    for ( auto edge : _edges ) {
+        delete edge;
+    }
+}
+
+
+/* Setup */
+
+//Add a stage, pipelines can be added only while stopped
+StatusCode ThreadedPipeline::AddStage( Pipeline* pPipeline, int cpu ) {
+    if ( !pPipeline || _running.load() ) {
+        return StatusCode::ERROR;
+    }
+    _stages.push_back( { pPipeline, cpu } );
+    _edges.push_back( new WaitableCircularBuffer( _edgeSize ) );
+    return StatusCode::OK;
+}
+
+//Start one thread per stage, pinned if asked so
+StatusCode ThreadedPipeline::Start( void ) {
+    if ( _running.load() || _stages.empty() ) {
+        return StatusCode::ERROR;
+    }
+    _faultyStage.store( 0 );
+    _lastError.store( StatusCode::OK );
+    _running.store( true );
+    for ( uint8_t i = 0; i < _stages.size(); ++i ) {
+        _threads.emplace_back( &ThreadedPipeline::run, this, i );
+        if ( 0 <= _stages[i].cpu ) {
+            cpu_set_t cpuset;
+            CPU_ZERO( &cpuset );
+            CPU_SET( _stages[i].cpu, &cpuset );
+            pthread_setaffinity_np( _threads.back().native_handle(), sizeof( cpuset ), &cpuset );
+        }
+    }
+    return StatusCode::OK;
+}
+
+//Stop and join the stage threads, data in the edges is kept
+void ThreadedPipeline::Stop( void ) {
+    _running.store( false );
+    for ( auto& thread : _threads ) {
+        thread.join();
+    }
+    _threads.clear();
+}
+
+bool ThreadedPipeline::isRunning( void ) const {
+    return _running.load();
+}
+
+
+/* Data in and out */
+
+//Put data into the input edge, PARTIAL if it is full
+StatusCode ThreadedPipeline::Sink( const uint8_t* data, uint16_t size, uint16_t* pAccepted ) {
+    uint16_t accepted = _edges.front()->put( data, size );
+    if ( pAccepted ) {
+        *pAccepted = accepted;
+    }
+    return ( accepted < size ) ? StatusCode::PARTIAL : StatusCode::OK;
+}
+
+//Take data from the output edge, waits up to timeoutMs for the first byte
+uint16_t ThreadedPipeline::Drain( uint8_t* data, uint16_t size, int32_t timeoutMs ) {
+    WaitableCircularBuffer* output = _edges.back();
+    if ( timeoutMs && !output->waitForData( 1, timeoutMs ) ) {
+        return 0;
+    }
+    return output->get( data, size );
+}
+
+
+/* Stage thread */
+
+//Parks a stage that needs more input. Input the front end has no room for
+//does not wake it up, so with a full outbound edge it waits for space there.
+static void waitForInput( WaitableCircularBuffer* inbound, WaitableCircularBuffer* outbound ) {
+    if ( inbound->isEmpty() ) {
+        inbound->waitForData( 1, STAGE_POLL_MS );
+    } else if ( outbound->isFull() ) {
+        outbound->waitForSpace( 1, STAGE_POLL_MS );
+    }
+    //else the pipes still move data, come back at once
+}
+
+void ThreadedPipeline::run( uint8_t index ) {
+
+    Pipeline*               pipeline    = _stages[index].pipeline;
+    WaitableCircularBuffer* inbound     = _edges[index];
+    WaitableCircularBuffer* outbound    = _edges[index + 1];
+
+    while ( _running.load( std::memory_order_relaxed ) ) {
+
+        //inbound edge -> front end free space
+        ByteArray* frontEnd = pipeline->getFrontEnd();
+        if ( frontEnd && frontEnd->data() ) {
+            uint16_t n = inbound->get( frontEnd->data() + frontEnd->count(),
+                                       frontEnd->size() - frontEnd->count() );
+            frontEnd->update_count( frontEnd->count() + n );
+        }
+
+        StatusCode status = pipeline->processAll();
+
+        //back end -> outbound edge, the rest stays for the next round
+        ByteArray* backEnd = pipeline->getBackEnd();
+        if ( backEnd && backEnd->count() ) {
+            uint16_t n = outbound->put( backEnd->data(), backEnd->count() );
+#if PIPELINE_TRACING
+            if ( n && PipelineTrace::isEnabled() ) {
+                PipelineTrace::handoff( pipeline->getName(), index + 1, n );
+            }
+#endif
+            if ( n ) {
+                std::memmove( backEnd->data(), backEnd->data() + n, backEnd->count() - n );
+                backEnd->update_count( backEnd->count() - n );
+            }
+            if ( backEnd->count() ) {
+                //downstream is slower, backpressure
+                outbound->waitForSpace( 1, STAGE_POLL_MS );
+                continue;
+            }
+        }
+
+        switch ( status ) {
+        case StatusCode::OK:            //quantum finished, come back at once
+        case StatusCode::REPEAT:
+            break;
+
+        case StatusCode::NEXT:          //went through, park only if nothing is left
+            if ( frontEnd && frontEnd->count() ) {
+                break;
+            }
+            inbound->waitForData( 1, STAGE_POLL_MS );
+            break;
+
+        case StatusCode::PENDING:       //needs more input
+            waitForInput( inbound, outbound );
+            break;
+
+        default:                        //ERROR, PARTIAL: the stage's handler was called
+            _lastError.store( status );
+            _faultyStage.store( index + 1 );
+            waitForInput( inbound, outbound );
+            break;
+        }
+    }
+}
+
+
+/* Other utility functions */
+
+uint8_t ThreadedPipeline::getStageCount( void ) const {
+    return _stages.size();
+}
+
+//Count stages from 1, 0 if no stage failed since Start()
+uint8_t ThreadedPipeline::getFaultyStage( void ) const {
+    return _faultyStage.load();
+}
+
+StatusCode ThreadedPipeline::getLastError( void ) const {
+    return _lastError.load();
+}
+
+#endif // __linux__
@@ -0,0 +1,78 @@
+/**
+ * @file    ThreadedPipeline.h
+ *
+ * @brief   Declaration of ThreadedPipeline
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _THREADEDPIPELINE_H_
+#define _THREADEDPIPELINE_H_
+
+#if defined( __linux__ )
+
+#include "Pipeline.h"
+#include "WaitableCircularBuffer.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/*
+ * ThreadedPipeline runs every stage on its own thread. A stage is a whole
+ * Pipeline, so a group of pipes that should share a thread is simply built
+ * as one Pipeline. Stages are chained by SPSC WaitableCircularBuffer edges:
+ * the stage thread moves bytes from its inbound edge into the front end,
+ * calls processAll() and moves the back end into the outbound edge.
+ * processAll() keeps the StatusCode semantics inside a stage: OK and REPEAT
+ * come back for more at once, PENDING (or NEXT with nothing left in the
+ * front end) parks the thread on the inbound edge until data arrives.
+ */
+
+class ThreadedPipeline {
+
+public:
+    ThreadedPipeline( uint16_t edgeSize = 1024 );
+    ~ThreadedPipeline();
+
+    StatusCode AddStage( Pipeline* pPipeline, int cpu = -1 );      //cpu < 0: not pinned
+
+    StatusCode Start( void );
+    void       Stop( void );
+    bool       isRunning( void ) const;
+
+    StatusCode Sink( const uint8_t* data, uint16_t size, uint16_t* pAccepted = nullptr );
+    uint16_t   Drain( uint8_t* data, uint16_t size, int32_t timeoutMs = 0 );
+
+    uint8_t    getStageCount( void ) const;
+    uint8_t    getFaultyStage( void ) const;
+    StatusCode getLastError( void ) const;
+
+private:
+
+    struct Stage {
+        Pipeline*   pipeline;
+        int         cpu;
+    };
+
+    void       run( uint8_t index );
+
+    uint16_t                                _edgeSize;
+    std::atomic<bool>                       _running;
+    std::atomic<uint8_t>                    _faultyStage;
+    std::atomic<StatusCode>                 _lastError;
+
+    std::vector<Stage>                      _stages;
+    std::vector<WaitableCircularBuffer*>    _edges;     //_stages.size() + 1, [0] is the input
+    std::vector<std::thread>                _threads;
+};
+
+#endif // __linux__
+
+#endif // _THREADEDPIPELINE_H_
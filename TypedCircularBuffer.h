@@ -0,0 +1,223 @@
+/**
+ * @file    TypedCircularBuffer.h
+ *
+ * @brief   Declaration of class template TypedCircularBuffer
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _TypedCircularBuffer_H_
+#define _TypedCircularBuffer_H_
+
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>        //std::rotate
+#include <type_traits>
+
+/**
+ * @brief   The TypedCircularBuffer class template is CircularBuffer for samples:
+ *          it stores T instead of uint8_t, so uint16_t, int32_t or float streams
+ *          are pushed and popped in bulk with memcpy and read in place.
+ *          As CircularBuffer::put, push overwrites the oldest samples when full.
+ */
+
+template < typename T >
+
+class TypedCircularBuffer {
+
+    static_assert( std::is_trivially_copyable<T>::value,
+        "TypedCircularBuffer stores samples by memcpy" );
+
+public:
+    //contiguous run of samples inside the ring
+    struct Span {
+        const T*    data;
+        uint16_t    count;
+    };
+
+    //constructor, not initialised buffer of size samples
+    TypedCircularBuffer( uint16_t size ) :
+        _size( size ), _count( 0 ), _head( 0 ), _tail( 0 ), _data( new T[size] ) {}
+
+    ~TypedCircularBuffer() {
+        delete[] _data;
+    }
+
+    TypedCircularBuffer( const TypedCircularBuffer& other ) = delete;
+    TypedCircularBuffer& operator = ( const TypedCircularBuffer& other ) = delete;
+
+    //size of the ring in samples
+    uint16_t size() const {
+        return _size;
+    }
+
+    //samples stored
+    uint16_t count() const {
+        return _count;
+    }
+
+    bool isEmpty() const {
+        return 0 == _count;
+    }
+
+    bool isFull() const {
+        return _size == _count;
+    }
+
+    void clear() {
+        _count = 0;
+        _head = _tail = 0;
+    }
+
+    //add a sample, the oldest one is overwritten when full
+    void push( const T& item ) {
+        if ( 0 == _size ) {
+            return;
+        }
+        _data[_head] = item;
+        if ( ++_head >= _size ) {
+            _head = 0;
+        }
+        if ( _count == _size ) {
+            _tail = _head;
+        } else {
+            ++_count;
+        }
+    }
+
+    //add n samples with at most two memcpy, the oldest ones are overwritten when full
+    void push( const T* items, uint16_t n ) {
+        if ( 0 == _size ) {
+            return;
+        }
+        if ( n >= _size ) {
+            //only the newest _size samples survive
+            std::memcpy( _data, items + ( n - _size ), _size * sizeof( T ) );
+            _head  = 0;
+            _tail  = 0;
+            _count = _size;
+            return;
+        }
+        uint16_t first = _size - _head;
+        if ( first > n ) {
+            first = n;
+        }
+        std::memcpy( _data + _head, items, first * sizeof( T ) );
+        std::memcpy( _data, items + first, ( n - first ) * sizeof( T ) );
+        _head += n;
+        if ( _head >= _size ) {
+            _head -= _size;
+        }
+        uint32_t count = (uint32_t)_count + n;
+        if ( count > _size ) {
+            _count = _size;
+            _tail  = _head;
+        } else {
+            _count = (uint16_t)count;
+        }
+    }
+
+    //remove and return the oldest sample, T() if empty
+    T pop() {
+        if ( 0 == _count ) {
+            return T();
+        }
+        T item = _data[_tail];
+        if ( ++_tail >= _size ) {
+            _tail = 0;
+        }
+        --_count;
+        return item;
+    }
+
+    //remove up to n oldest samples into items, returns samples copied
+    uint16_t pop( T* items, uint16_t n ) {
+        Span first, second;
+        n = peek( 0, n, &first, &second );
+        std::memcpy( items, first.data, first.count * sizeof( T ) );
+        std::memcpy( items + first.count, second.data, second.count * sizeof( T ) );
+        drop( n );
+        return n;
+    }
+
+    //discard up to n oldest samples, returns samples discarded
+    uint16_t drop( uint16_t n ) {
+        if ( n > _count ) {
+            n = _count;
+        }
+        _tail += n;
+        if ( _tail >= _size ) {
+            _tail -= _size;
+        }
+        _count -= n;
+        return n;
+    }
+
+    //sample at index, 0 is the oldest, T() if out of range
+    T at( uint16_t index ) const {
+        if ( index >= _count ) {
+            return T();
+        }
+        uint16_t pos = _tail + index;
+        if ( pos >= _size ) {
+            pos -= _size;
+        }
+        return _data[pos];
+    }
+
+    //n samples from index (0 is the oldest) as up to two contiguous spans,
+    //second.count is 0 when the run does not wrap; returns samples spanned
+    uint16_t peek( uint16_t index, uint16_t n, Span* first, Span* second ) const {
+        if ( index > _count ) {
+            index = _count;
+        }
+        if ( n > _count - index ) {
+            n = _count - index;
+        }
+        uint16_t pos = _tail + index;
+        if ( pos >= _size ) {
+            pos -= _size;
+        }
+        uint16_t run = _size - pos;
+        if ( run > n ) {
+            run = n;
+        }
+        first->data   = _data + pos;
+        first->count  = run;
+        second->data  = _data;
+        second->count = n - run;
+        return n;
+    }
+
+    //newest n samples as up to two contiguous spans
+    uint16_t last( uint16_t n, Span* first, Span* second ) const {
+        if ( n > _count ) {
+            n = _count;
+        }
+        return peek( _count - n, n, first, second );
+    }
+
+    //rotate the storage so all samples are contiguous, returns the oldest one
+    const T* linearize() {
+        if ( (uint32_t)_tail + _count > _size ) {
+            std::rotate( _data, _data + _tail, _data + _size );
+            _tail = 0;
+            _head = ( _count == _size ) ? 0 : _count;
+        }
+        return _data + _tail;
+    }
+
+private:
+    uint16_t    _size;
+    uint16_t    _count;
+    uint16_t    _head;
+    uint16_t    _tail;
+    T* const    _data;
+};
+
+#endif // _TypedCircularBuffer_H_
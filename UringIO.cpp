@@ -0,0 +1,513 @@
+/**
+ * @file    UringIO.cpp
+ *
+ * @brief   Implementation of the UringIO class
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#if defined( __linux__ )
+
+#include <linux/io_uring.h>
+
+#include "UringIO.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+
+//no liburing: the three system calls and the ring memory by hand
+
+static int uringSetup( uint32_t entries, struct io_uring_params* pParams ) {
+    return (int)syscall( __NR_io_uring_setup, entries, pParams );
+}
+
+static int uringEnter( int fd, uint32_t submit, uint32_t complete, uint32_t flags ) {
+    return (int)syscall( __NR_io_uring_enter, fd, submit, complete, flags, nullptr, 0 );
+}
+
+static int uringRegister( int fd, uint32_t opcode, const void* arg, uint32_t count ) {
+    return (int)syscall( __NR_io_uring_register, fd, opcode, arg, count );
+}
+
+static void* mapRing( int fd, size_t size, off_t offset ) {
+    void* p = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset );
+    return ( MAP_FAILED == p ) ? nullptr : p;
+}
+
+
+UringIO::UringIO( uint16_t entries ) {
+    struct io_uring_params params;
+    memset( &params, 0, sizeof( params ) );
+    _fd = uringSetup( entries ? entries : 1, &params );
+    if ( _fd < 0 ) {
+        _fd = -1;
+        return;
+    }
+
+    _sqRingSize = params.sq_off.array + params.sq_entries * sizeof( uint32_t );
+    _cqRingSize = params.cq_off.cqes  + params.cq_entries * sizeof( struct io_uring_cqe );
+    if ( params.features & IORING_FEAT_SINGLE_MMAP ) {
+        if ( _cqRingSize > _sqRingSize ) {
+            _sqRingSize = _cqRingSize;
+        }
+        _cqRingSize = 0;                //shares the SQ mapping
+    }
+    _sqesSize = params.sq_entries * sizeof( struct io_uring_sqe );
+
+    _sqRing = mapRing( _fd, _sqRingSize, IORING_OFF_SQ_RING );
+    _cqRing = _cqRingSize ? mapRing( _fd, _cqRingSize, IORING_OFF_CQ_RING ) : _sqRing;
+    _sqes   = (struct io_uring_sqe*)mapRing( _fd, _sqesSize, IORING_OFF_SQES );
+    if ( !_sqRing || !_cqRing || !_sqes ) {
+        close( _fd );                   //the destructor unmaps what was mapped
+        _fd = -1;
+        return;
+    }
+
+    uint8_t* sq = (uint8_t*)_sqRing;
+    _sqHead      = (uint32_t*)( sq + params.sq_off.head );
+    _sqTail      = (uint32_t*)( sq + params.sq_off.tail );
+    _sqArray     = (uint32_t*)( sq + params.sq_off.array );
+    _sqMask      = *(uint32_t*)( sq + params.sq_off.ring_mask );
+    _sqEntries   = params.sq_entries;
+    _sqLocalTail = *_sqTail;
+
+    uint8_t* cq = (uint8_t*)_cqRing;
+    _cqHead      = (uint32_t*)( cq + params.cq_off.head );
+    _cqTail      = (uint32_t*)( cq + params.cq_off.tail );
+    _cqMask      = *(uint32_t*)( cq + params.cq_off.ring_mask );
+    _cqes        = (struct io_uring_cqe*)( cq + params.cq_off.cqes );
+}
+
+//Closing the ring cancels what is in flight, then the buffers go back
+UringIO::~UringIO() {
+    if ( 0 <= _fd ) {
+        close( _fd );
+    }
+    for ( auto& stream : _streams ) {
+        if ( stream.inflight ) {
+            stream.pool->release( stream.inflight );
+        }
+        for ( auto& chunk : stream.chunks ) {
+            if ( chunk.bid < 0 ) {
+                stream.pool->release( chunk.buffer );
+            }
+        }
+        for ( auto buffer : stream.provided ) {
+            stream.pool->release( buffer );
+        }
+        if ( stream.ring ) {
+            munmap( stream.ring, stream.ringEntries * sizeof( struct io_uring_buf ) );
+        }
+    }
+    if ( _sqes ) {
+        munmap( _sqes, _sqesSize );
+    }
+    if ( _cqRing && ( _cqRing != _sqRing ) ) {
+        munmap( _cqRing, _cqRingSize );
+    }
+    if ( _sqRing ) {
+        munmap( _sqRing, _sqRingSize );
+    }
+}
+
+
+/* Setup */
+
+bool UringIO::isOpen( void ) const {
+    return 0 <= _fd;
+}
+
+int16_t UringIO::AddSource( int fd, Pipeline* pPipeline, uint8_t PipeIndex, BufferPool* pPool ) {
+    if ( _started || fd < 0 || !pPipeline || !pPool || !pPool->size() ||
+         !PipeIndex || PipeIndex > pPipeline->getPipeCount() || _streams.size() >= 0x7FFF ) {
+        return -1;
+    }
+    struct stat info;
+    bool socket = ( 0 == fstat( fd, &info ) ) && S_ISSOCK( info.st_mode );
+    _streams.push_back( { fd, pPipeline, PipeIndex, true, socket, false, false, 0,
+                          pPool, 0, nullptr, 0, {}, nullptr, 0, 0, 0, {} } );
+    return _streams.size() - 1;
+}
+
+int16_t UringIO::AddSink( int fd, Pipeline* pPipeline, BufferPool* pPool ) {
+    if ( _started || fd < 0 || !pPipeline || !pPool || !pPool->size() ||
+         !pPipeline->getBackEnd() || _streams.size() >= 0x7FFF ) {
+        return -1;
+    }
+    _streams.push_back( { fd, pPipeline, pPipeline->getPipeCount(), false, false, false, false, 0,
+                          pPool, 0, nullptr, 0, {}, nullptr, 0, 0, 0, {} } );
+    return _streams.size() - 1;
+}
+
+//Provided buffer ring of a socket source, up to URING_PROVIDED_BUFFERS
+//pool buffers, a power of two; false leaves the source on READ_FIXED
+bool UringIO::setupRing( uint16_t id ) {
+    Stream&  stream  = _streams[id];
+    uint16_t entries = 1;
+    while ( ( entries << 1 ) <= stream.pool->available() && ( entries << 1 ) <= URING_PROVIDED_BUFFERS ) {
+        entries <<= 1;
+    }
+    if ( entries > stream.pool->available() ) {
+        return false;
+    }
+
+    size_t size = entries * sizeof( struct io_uring_buf );
+    void*  ring = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( MAP_FAILED == ring ) {
+        return false;
+    }
+    struct io_uring_buf_reg reg;
+    memset( &reg, 0, sizeof( reg ) );
+    reg.ring_addr    = (uint64_t)(uintptr_t)ring;
+    reg.ring_entries = entries;
+    reg.bgid         = id;
+    if ( uringRegister( _fd, IORING_REGISTER_PBUF_RING, &reg, 1 ) < 0 ) {
+        munmap( ring, size );
+        return false;
+    }
+
+    stream.ring        = (struct io_uring_buf_ring*)ring;
+    stream.ringEntries = entries;
+    for ( uint16_t bid = 0; bid < entries; ++bid ) {
+        stream.provided.push_back( stream.pool->acquire() );
+        provide( stream, bid );
+    }
+    return true;
+}
+
+StatusCode UringIO::Start( void ) {
+    if ( !isOpen() || _started ) {
+        return StatusCode::ERROR;
+    }
+
+    //one registered buffer per pool, covering all of its storage
+    std::vector<struct iovec> iovecs;
+    for ( auto& stream : _streams ) {
+        uint16_t index = 0;
+        while ( index < _pools.size() && _pools[index] != stream.pool ) {
+            ++index;
+        }
+        if ( index == _pools.size() ) {
+            _pools.push_back( stream.pool );
+            iovecs.push_back( { stream.pool->storage(),
+                                (size_t)stream.pool->size() * stream.pool->bufferSize() } );
+        }
+        stream.bufIndex = index;
+    }
+    if ( iovecs.size() &&
+         uringRegister( _fd, IORING_REGISTER_BUFFERS, iovecs.data(), iovecs.size() ) < 0 ) {
+        return StatusCode::ERROR;
+    }
+
+    for ( uint16_t id = 0; id < _streams.size(); ++id ) {
+        if ( _streams[id].socket && !setupRing( id ) ) {
+            _streams[id].socket = false;
+        }
+        arm( id );
+    }
+    _started = true;
+    if ( _toSubmit ) {
+        enter( false );
+    }
+    return StatusCode::OK;
+}
+
+
+/* Ring */
+
+//Next free submission entry, flushes the queue when it is full
+struct io_uring_sqe* UringIO::getSqe( void ) {
+    if ( _sqLocalTail - __atomic_load_n( _sqHead, __ATOMIC_ACQUIRE ) >= _sqEntries ) {
+        enter( false );
+        if ( _sqLocalTail - __atomic_load_n( _sqHead, __ATOMIC_ACQUIRE ) >= _sqEntries ) {
+            return nullptr;
+        }
+    }
+    uint32_t index = _sqLocalTail & _sqMask;
+    struct io_uring_sqe* sqe = &_sqes[index];
+    memset( sqe, 0, sizeof( *sqe ) );
+    _sqArray[index] = index;
+    ++_sqLocalTail;
+    ++_toSubmit;
+    return sqe;
+}
+
+//Publishes the queued entries, optionally waits for one completion
+bool UringIO::enter( bool wait ) {
+    __atomic_store_n( _sqTail, _sqLocalTail, __ATOMIC_RELEASE );
+    int ret = uringEnter( _fd, _toSubmit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0 );
+    ++_syscalls;
+    if ( ret < 0 ) {
+        return false;                   //EINTR, EBUSY: the entries stay queued
+    }
+    _toSubmit -= ( (uint32_t)ret < _toSubmit ) ? (uint32_t)ret : _toSubmit;
+    return true;
+}
+
+bool UringIO::reap( void ) {
+    uint32_t head = *_cqHead;
+    uint32_t tail = __atomic_load_n( _cqTail, __ATOMIC_ACQUIRE );
+    if ( head == tail ) {
+        return false;
+    }
+    for ( ; head != tail; ++head ) {
+        struct io_uring_cqe* cqe = &_cqes[head & _cqMask];
+        if ( cqe->user_data < _streams.size() ) {
+            complete( _streams[cqe->user_data], cqe->res, cqe->flags );
+        }
+        ++_completions;
+    }
+    __atomic_store_n( _cqHead, head, __ATOMIC_RELEASE );
+    return true;
+}
+
+//Hands buffer bid (back) to the provided buffer ring
+void UringIO::provide( Stream& stream, uint16_t bid ) {
+    ByteArray* buffer = stream.provided[bid];
+    buffer->clear();
+    struct io_uring_buf* entry = &stream.ring->bufs[stream.ringTail & ( stream.ringEntries - 1 )];
+    entry->addr = (uint64_t)(uintptr_t)buffer->data();
+    entry->len  = buffer->size();
+    entry->bid  = bid;
+    ++stream.ringTail;
+    ++stream.ringFree;
+    __atomic_store_n( &stream.ring->tail, stream.ringTail, __ATOMIC_RELEASE );
+}
+
+
+//Back to READ_FIXED: the ring is unregistered, its buffers become plain
+//pool buffers, those holding data when drained
+void UringIO::dropRing( Stream& stream ) {
+    struct io_uring_buf_reg reg;
+    memset( &reg, 0, sizeof( reg ) );
+    reg.bgid = &stream - _streams.data();
+    uringRegister( _fd, IORING_UNREGISTER_PBUF_RING, &reg, 1 );
+    munmap( stream.ring, stream.ringEntries * sizeof( struct io_uring_buf ) );
+
+    for ( auto buffer : stream.provided ) {
+        bool held = false;
+        for ( auto& chunk : stream.chunks ) {
+            held |= ( chunk.buffer == buffer );
+        }
+        if ( !held ) {
+            stream.pool->release( buffer );
+        }
+    }
+    for ( auto& chunk : stream.chunks ) {
+        chunk.bid = -1;
+    }
+    stream.provided.clear();
+    stream.ring     = nullptr;
+    stream.ringFree = 0;
+    stream.socket   = false;
+}
+
+
+/* Streams */
+
+void UringIO::complete( Stream& stream, int32_t res, uint32_t flags ) {
+
+    if ( !stream.source ) {             //WRITE_FIXED
+        stream.armed = false;
+        if ( 0 < res ) {
+            stream.written += res;
+            if ( stream.written >= stream.inflight->count() ) {
+                stream.pool->release( stream.inflight );
+                stream.inflight = nullptr;
+            }
+        } else if ( ( -EAGAIN != res ) && ( -EINTR != res ) ) {
+            stream.pool->release( stream.inflight );
+            stream.inflight = nullptr;
+            stream.closed   = true;
+            stream.error    = res ? -res : EPIPE;
+        }
+        return;
+    }
+
+    if ( stream.socket ) {              //multishot receive
+        if ( !( flags & IORING_CQE_F_MORE ) ) {
+            stream.armed = false;       //ended, re-armed by arm()
+        }
+        if ( 0 < res && ( flags & IORING_CQE_F_BUFFER ) ) {
+            uint16_t bid = flags >> IORING_CQE_BUFFER_SHIFT;
+            if ( bid < stream.provided.size() ) {
+                stream.provided[bid]->update_count( res );
+                stream.chunks.push_back( { stream.provided[bid], 0, bid } );
+                --stream.ringFree;
+            }
+        } else if ( 0 == res ) {
+            stream.closed = true;       //end of stream
+        } else if ( -EINVAL == res ) {
+            dropRing( stream );         //no multishot on this kernel, read instead
+        } else if ( ( res < 0 ) && ( -ENOBUFS != res ) && ( -EAGAIN != res ) && ( -EINTR != res ) ) {
+            stream.closed = true;
+            stream.error  = -res;
+        }
+        return;
+    }
+
+    stream.armed = false;               //READ_FIXED
+    if ( 0 < res ) {
+        stream.inflight->update_count( res );
+        stream.chunks.push_back( { stream.inflight, 0, -1 } );
+        stream.inflight = nullptr;
+    } else if ( ( -EAGAIN != res ) && ( -EINTR != res ) ) {
+        stream.pool->release( stream.inflight );
+        stream.inflight = nullptr;
+        stream.closed   = true;
+        stream.error    = res ? -res : 0;
+    }
+}
+
+//Source: received data into the pipe, as much as fits.
+//Sink: back end into a pool buffer for the next write.
+bool UringIO::drain( Stream& stream ) {
+    bool moved = false;
+
+    if ( stream.source ) {
+        while ( stream.chunks.size() ) {
+            Chunk& chunk = stream.chunks.front();
+            uint16_t accepted = 0;
+            stream.pipeline->Sink( stream.pipe, chunk.buffer->data() + chunk.offset,
+                                   chunk.buffer->count() - chunk.offset, &accepted );
+            chunk.offset += accepted;
+            moved        |= ( 0 != accepted );
+            if ( chunk.offset < chunk.buffer->count() ) {
+                break;                  //the pipe is full, the rest waits
+            }
+            if ( 0 <= chunk.bid ) {
+                provide( stream, chunk.bid );
+            } else {
+                stream.pool->release( chunk.buffer );
+            }
+            stream.chunks.pop_front();
+        }
+        return moved;
+    }
+
+    ByteArray* backEnd = stream.pipeline->getBackEnd();
+    if ( stream.inflight || stream.closed || !backEnd || !backEnd->count() ) {
+        return false;
+    }
+    ByteArray* buffer = stream.pool->acquire();
+    if ( !buffer ) {
+        return false;
+    }
+    uint16_t n = buffer->append( backEnd->data(), backEnd->count() );
+    memmove( backEnd->data(), backEnd->data() + n, backEnd->count() - n );
+    backEnd->update_count( backEnd->count() - n );
+    stream.pipeline->markReady( stream.pipe );  //its output has room again
+    stream.inflight = buffer;
+    stream.written  = 0;
+    return true;
+}
+
+//Puts the next request of a stream in the submission queue
+void UringIO::arm( uint16_t id ) {
+    Stream& stream = _streams[id];
+    if ( stream.armed || stream.closed ) {
+        return;
+    }
+
+    struct io_uring_sqe* sqe;
+    if ( !stream.source ) {
+        if ( !stream.inflight || !( sqe = getSqe() ) ) {
+            return;
+        }
+        sqe->opcode    = IORING_OP_WRITE_FIXED;
+        sqe->addr      = (uint64_t)(uintptr_t)( stream.inflight->data() + stream.written );
+        sqe->len       = stream.inflight->count() - stream.written;
+        sqe->buf_index = stream.bufIndex;
+
+    } else if ( stream.socket ) {
+        if ( !stream.ringFree || !( sqe = getSqe() ) ) {
+            return;                     //re-armed when buffers come back
+        }
+        sqe->opcode    = IORING_OP_RECV;
+        sqe->ioprio    = IORING_RECV_MULTISHOT;
+        sqe->flags     = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = id;
+
+    } else {
+        if ( stream.chunks.size() ) {
+            return;                     //the pipe has not taken the last read yet
+        }
+        if ( !stream.inflight ) {
+            stream.inflight = stream.pool->acquire();
+        }
+        if ( !stream.inflight || !( sqe = getSqe() ) ) {
+            return;
+        }
+        sqe->opcode    = IORING_OP_READ_FIXED;
+        sqe->addr      = (uint64_t)(uintptr_t)stream.inflight->data();
+        sqe->len       = stream.inflight->size();
+        sqe->buf_index = stream.bufIndex;
+    }
+
+    sqe->fd        = stream.fd;
+    sqe->off       = (uint64_t)-1;     //current position, streams have none
+    sqe->user_data = id;
+    stream.armed   = true;
+}
+
+StatusCode UringIO::poll( bool wait ) {
+    if ( !_started ) {
+        return StatusCode::ERROR;
+    }
+
+    bool moved = false;
+    for ( int pass = 0; pass < 2; ++pass ) {
+        moved |= reap();
+        bool armed = false;
+        for ( uint16_t id = 0; id < _streams.size(); ++id ) {
+            moved |= drain( _streams[id] );
+            arm( id );
+            armed |= _streams[id].armed;
+        }
+        if ( moved || !wait || !armed ) {
+            break;
+        }
+        enter( true );                  //submits and sleeps until a completion
+    }
+
+    if ( _toSubmit ) {
+        enter( false );
+    }
+    return moved ? StatusCode::OK : StatusCode::PENDING;
+}
+
+
+/* Other utility functions */
+
+int UringIO::ringFd( void ) const {
+    return _fd;
+}
+
+bool UringIO::isClosed( uint16_t id ) const {
+    return ( id < _streams.size() ) && _streams[id].closed && _streams[id].chunks.empty();
+}
+
+int UringIO::getError( uint16_t id ) const {
+    return ( id < _streams.size() ) ? _streams[id].error : 0;
+}
+
+uint64_t UringIO::getSyscalls( void ) const {
+    return _syscalls;
+}
+
+uint64_t UringIO::getCompletions( void ) const {
+    return _completions;
+}
+
+#endif // __linux__
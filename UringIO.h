@@ -0,0 +1,148 @@
+/**
+ * @file    UringIO.h
+ *
+ * @brief   Declaration of UringIO
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _URINGIO_H_
+#define _URINGIO_H_
+
+#if defined( __linux__ )
+
+
+//pool buffers a socket source keeps in its provided buffer ring, a power of 2
+#ifndef URING_PROVIDED_BUFFERS
+#define URING_PROVIDED_BUFFERS 32
+#endif
+
+
+#include "Pipeline.h"
+#include "BufferPool.h"
+
+#include <deque>
+#include <vector>
+
+
+/*
+ * UringIO moves data between file descriptors and Pipelines through one
+ * io_uring, so many fds cost one io_uring_enter() per poll() instead of a
+ * read() or write() per fd. A source feeds the input of a pipe, a sink
+ * writes out the back end of a pipeline.
+ *
+ * The storage of every BufferPool given is registered with the ring once.
+ * A socket source arms one multishot receive that takes buffers from a
+ * provided buffer ring filled from its pool and keeps completing until
+ * the ring runs dry; other fds (pipes, ttys, files) get one READ_FIXED
+ * into a pool buffer at a time. Received data goes into the pipe with
+ * Pipeline::Sink(), which marks the pipe ready for processReady() and
+ * signals eventFd(), so the stages wake up on completions. What does not
+ * fit stays in its buffer until a later poll(). A sink copies the back end
+ * into a pool buffer, empties it and marks the last pipe ready, and a
+ * WRITE_FIXED sends the buffer, short writes are continued.
+ *
+ * Everything runs on the thread calling poll(). Streams are added before
+ * Start(), the pools and pipelines must outlive the UringIO.
+ */
+
+class UringIO {
+
+public:
+    UringIO( uint16_t entries = 256 );
+    ~UringIO();
+
+    UringIO( const UringIO& other ) = delete;
+    UringIO& operator = ( const UringIO& other ) = delete;
+
+    bool       isOpen( void ) const;                        //false if io_uring is not available
+
+    int16_t    AddSource( int fd, Pipeline* pPipeline, uint8_t PipeIndex, BufferPool* pPool );  //id, -1 on error
+    int16_t    AddSink(   int fd, Pipeline* pPipeline, BufferPool* pPool );                     //writes the back end
+
+    StatusCode Start( void );                               //registers buffers, arms the sources
+    StatusCode poll( bool wait = false );                   //OK: data moved, PENDING: nothing to do
+    int        ringFd( void ) const;                        //readable with completions, for epoll
+
+    bool       isClosed( uint16_t id ) const;               //end of stream or error
+    int        getError( uint16_t id ) const;               //errno of a failed stream, 0 if none
+    uint64_t   getSyscalls( void ) const;                   //io_uring_enter() calls
+    uint64_t   getCompletions( void ) const;
+
+private:
+
+    //received bytes not in the pipeline yet
+    struct Chunk {
+        ByteArray*  buffer;
+        uint16_t    offset;
+        int32_t     bid;                //provided buffer id, -1 for READ_FIXED
+    };
+
+    struct Stream {
+        int                     fd;
+        Pipeline*               pipeline;
+        uint8_t                 pipe;           //source: pipe fed, count pipes from 1
+        bool                    source;
+        bool                    socket;         //multishot receive
+        bool                    armed;          //a request is in flight
+        bool                    closed;
+        int                     error;
+        BufferPool*             pool;
+        uint16_t                bufIndex;       //registered buffer of the pool
+        ByteArray*              inflight;       //of READ_FIXED or WRITE_FIXED
+        uint16_t                written;        //sink: bytes of inflight sent
+        std::deque<Chunk>       chunks;         //source: received, not in the pipe yet
+        //provided buffer ring of a socket source, group id is the stream id
+        struct io_uring_buf_ring* ring;
+        uint16_t                ringEntries;
+        uint16_t                ringTail;
+        uint16_t                ringFree;       //buffers in the ring
+        std::vector<ByteArray*> provided;       //by buffer id
+    };
+
+    struct io_uring_sqe* getSqe( void );
+    bool       enter( bool wait );
+    bool       reap( void );
+    void       complete( Stream& stream, int32_t res, uint32_t flags );
+    bool       drain( Stream& stream );
+    void       arm( uint16_t id );
+    void       provide( Stream& stream, uint16_t bid );
+    bool       setupRing( uint16_t id );
+    void       dropRing( Stream& stream );
+
+    int                     _fd             = -1;
+    bool                    _started        = false;
+    uint64_t                _syscalls       = 0;
+    uint64_t                _completions    = 0;
+
+    //mapped rings
+    void*                   _sqRing         = nullptr;
+    void*                   _cqRing         = nullptr;
+    size_t                  _sqRingSize     = 0;
+    size_t                  _cqRingSize     = 0;
+    struct io_uring_sqe*    _sqes           = nullptr;
+    size_t                  _sqesSize       = 0;
+    uint32_t*               _sqHead         = nullptr;
+    uint32_t*               _sqTail         = nullptr;
+    uint32_t*               _sqArray        = nullptr;
+    uint32_t                _sqMask         = 0;
+    uint32_t                _sqEntries      = 0;
+    uint32_t                _sqLocalTail    = 0;
+    uint32_t                _toSubmit       = 0;
+    uint32_t*               _cqHead         = nullptr;
+    uint32_t*               _cqTail         = nullptr;
+    uint32_t                _cqMask         = 0;
+    struct io_uring_cqe*    _cqes           = nullptr;
+
+    std::vector<BufferPool*>    _pools;             //registered buffer index
+    std::vector<Stream>         _streams;
+};
+
+#endif // __linux__
+
+#endif // _URINGIO_H_
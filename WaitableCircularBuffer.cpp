@@ -0,0 +1,368 @@
+/**
+ * @file    WaitableCircularBuffer.cpp
+ *
+ * @brief   Implementation of class WaitableCircularBuffer
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#if defined( __linux__ )
+
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "Futex.h"
+#include "WaitableCircularBuffer.h"
+
+
+/**
+  * @brief  class constructor
+  *
+  * @param  size         ring size
+  *         withEventFd  create an eventfd that becomes readable when data arrives
+ */
+WaitableCircularBuffer::WaitableCircularBuffer( uint16_t size, bool withEventFd ) :
+    _ByteArray( size ),
+    _written( 0 ), _spaceWaiters( 0 ), _spaceWanted( 0 ),
+    _read( 0 ), _dataWaiters( 0 ), _dataWanted( 0 ), _armed( true ) {
+    if ( withEventFd ) {
+        _eventFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    }
+}
+
+
+/**
+  * @brief  class destructor
+  *
+  * @param  -
+ */
+WaitableCircularBuffer::~WaitableCircularBuffer( void ) {
+    if ( 0 <= _eventFd ) {
+        close( _eventFd );
+    }
+}
+
+
+/**
+ * @brief   returns count of bytes in the ring
+ *
+ * @param   -
+ *
+ * @return  bytes ready to get
+ */
+uint16_t
+WaitableCircularBuffer::count( void ) const {
+    return (uint16_t)( _written.load( std::memory_order_acquire ) -
+                       _read.load( std::memory_order_acquire ) );
+}
+
+
+/**
+ * @brief   returns size of the ring
+ *
+ * @param   -
+ *
+ * @return  ring size
+ */
+uint16_t
+WaitableCircularBuffer::size( void ) const {
+    return _ByteArray.size();
+}
+
+
+/**
+ * @brief   returns free space of the ring
+ *
+ * @param   -
+ *
+ * @return  bytes that can be put without blocking
+ */
+uint16_t
+WaitableCircularBuffer::space( void ) const {
+    return _ByteArray.size() - count();
+}
+
+
+/**
+ * @brief   returns flag indicating that bufer is empty
+ *
+ * @param   -
+ *
+ * @return  buffer is empty flag
+ */
+bool
+WaitableCircularBuffer::isEmpty( void ) const {
+    return 0 == count();
+}
+
+
+/**
+ * @brief   returns flag indicating that bufer is full
+ *
+ * @param   -
+ *
+ * @return  buffer is full flag
+ */
+bool
+WaitableCircularBuffer::isFull( void ) const {
+    return _ByteArray.size() == count();
+}
+
+
+/**
+ * @brief   puts a byte, producer side
+ *
+ * @param   abyte   byte to put
+ *
+ * @return  false if the ring is full
+ */
+bool
+WaitableCircularBuffer::put( uint8_t abyte ) {
+    return 1 == put( &abyte, 1 );
+}
+
+
+/**
+ * @brief   puts as many bytes as fit, producer side
+ *
+ * @param   data    bytes to put
+ *          n       byte count
+ *
+ * @return  bytes put
+ */
+uint16_t
+WaitableCircularBuffer::put( const uint8_t* data, uint16_t n ) {
+    uint32_t written = _written.load( std::memory_order_relaxed );
+    uint32_t read    = _read.load( std::memory_order_acquire );
+    uint16_t free    = _ByteArray.size() - (uint16_t)( written - read );
+    if ( n > free ) {
+        n = free;
+    }
+    if ( 0 == n ) {
+        return 0;
+    }
+    //at most two memcpy, up to the end and from the start
+    uint16_t first = _ByteArray.size() - _head;
+    if ( first > n ) {
+        first = n;
+    }
+    std::memcpy( _ByteArray.data() + _head, data, first );
+    std::memcpy( _ByteArray.data(), data + first, n - first );
+    _head += n;
+    if ( _head >= _ByteArray.size() ) {
+        _head -= _ByteArray.size();
+    }
+    publish( written + n, read );
+    return n;
+}
+
+
+/**
+ * @brief   returns oldest byte, consumer side
+ *
+ * @param   -
+ *
+ * @return  byte at tail, 0 if empty
+ */
+uint8_t
+WaitableCircularBuffer::get( void ) {
+    uint8_t abyte = 0;
+    get( &abyte, 1 );
+    return abyte;
+}
+
+
+/**
+ * @brief   takes up to n oldest bytes, consumer side
+ *
+ * @param   data    destination
+ *          n       max byte count
+ *
+ * @return  bytes taken
+ */
+uint16_t
+WaitableCircularBuffer::get( uint8_t* data, uint16_t n ) {
+    uint32_t read    = _read.load( std::memory_order_relaxed );
+    uint32_t written = _written.load( std::memory_order_acquire );
+    uint16_t filled  = (uint16_t)( written - read );
+    if ( n > filled ) {
+        n = filled;
+    }
+    if ( n ) {
+        uint16_t first = _ByteArray.size() - _tail;
+        if ( first > n ) {
+            first = n;
+        }
+        std::memcpy( data, _ByteArray.data() + _tail, first );
+        std::memcpy( data + first, _ByteArray.data(), n - first );
+        _tail += n;
+        if ( _tail >= _ByteArray.size() ) {
+            _tail -= _ByteArray.size();
+        }
+        release( written, read + n );
+    } else if ( 0 <= _eventFd ) {
+        release( written, read );
+    }
+    return n;
+}
+
+
+/**
+ * @brief   consumer: sleeps until at least minBytes can be taken
+ *
+ * @param   minBytes    bytes required
+ *          timeoutMs   timeout in ms, -1 waits forever
+ *
+ * @return  true if the data is there, false on timeout
+ */
+bool
+WaitableCircularBuffer::waitForData( uint16_t minBytes, int32_t timeoutMs ) {
+    if ( minBytes > _ByteArray.size() ) {
+        return false;
+    }
+    int64_t deadline = ( 0 <= timeoutMs ) ? monotonicMs() + timeoutMs : 0;
+    uint32_t read = _read.load( std::memory_order_relaxed );
+    for ( ;; ) {
+        uint32_t written = _written.load( std::memory_order_acquire );
+        if ( written - read >= minBytes ) {
+            return true;
+        }
+        int32_t remaining = -1;
+        if ( 0 <= timeoutMs ) {
+            int64_t left = deadline - monotonicMs();
+            if ( left <= 0 ) {
+                return false;
+            }
+            remaining = (int32_t)left;
+        }
+        //announce the sleeper, then look once more before parking
+        _dataWanted.store( minBytes, std::memory_order_relaxed );
+        _dataWaiters.fetch_add( 1, std::memory_order_seq_cst );
+        written = _written.load( std::memory_order_seq_cst );
+        if ( written - read < minBytes ) {
+            futexWait( &_written, written, remaining );
+        }
+        _dataWaiters.fetch_sub( 1, std::memory_order_relaxed );
+    }
+}
+
+
+/**
+ * @brief   producer: sleeps until n bytes can be put
+ *
+ * @param   n           free bytes required
+ *          timeoutMs   timeout in ms, -1 waits forever
+ *
+ * @return  true if the space is there, false on timeout
+ */
+bool
+WaitableCircularBuffer::waitForSpace( uint16_t n, int32_t timeoutMs ) {
+    if ( n > _ByteArray.size() ) {
+        return false;
+    }
+    int64_t deadline = ( 0 <= timeoutMs ) ? monotonicMs() + timeoutMs : 0;
+    uint32_t written = _written.load( std::memory_order_relaxed );
+    for ( ;; ) {
+        uint32_t read = _read.load( std::memory_order_acquire );
+        if ( _ByteArray.size() - ( written - read ) >= n ) {
+            return true;
+        }
+        int32_t remaining = -1;
+        if ( 0 <= timeoutMs ) {
+            int64_t left = deadline - monotonicMs();
+            if ( left <= 0 ) {
+                return false;
+            }
+            remaining = (int32_t)left;
+        }
+        _spaceWanted.store( n, std::memory_order_relaxed );
+        _spaceWaiters.fetch_add( 1, std::memory_order_seq_cst );
+        read = _read.load( std::memory_order_seq_cst );
+        if ( _ByteArray.size() - ( written - read ) < n ) {
+            futexWait( &_read, read, remaining );
+        }
+        _spaceWaiters.fetch_sub( 1, std::memory_order_relaxed );
+    }
+}
+
+
+/**
+ * @brief   returns eventfd which becomes readable when the ring turns non-empty,
+ *          the consumer re-arms it by draining the ring with get(),
+ *          a get() that returns 0 after a spurious wakeup re-arms it as well
+ *
+ * @param   -
+ *
+ * @return  eventfd or -1 if it was not requested
+ */
+int
+WaitableCircularBuffer::eventFd( void ) const {
+    return _eventFd;
+}
+
+
+/**
+ * @brief   producer: makes the new bytes visible and wakes the consumer
+ *          only if it is parked or the eventfd is armed
+ *
+ * @param   written     new producer total
+ *          read        consumer total as seen by the producer
+ *
+ * @return  -
+ */
+void
+WaitableCircularBuffer::publish( uint32_t written, uint32_t read ) {
+    _written.store( written, std::memory_order_seq_cst );
+    if ( _dataWaiters.load( std::memory_order_seq_cst ) ) {
+        //read may be stale, the count is never underestimated
+        if ( written - read >= _dataWanted.load( std::memory_order_relaxed ) ) {
+            futexWake( &_written );
+        }
+    }
+    if ( 0 <= _eventFd ) {
+        if ( _armed.load( std::memory_order_seq_cst ) &&
+             _armed.exchange( false, std::memory_order_seq_cst ) ) {
+            uint64_t one = 1;
+            if ( ::write( _eventFd, &one, sizeof( one ) ) ) {}
+        }
+    }
+}
+
+
+/**
+ * @brief   consumer: frees the taken bytes, wakes the producer only if it is parked,
+ *          re-arms the eventfd once the ring is drained
+ *
+ * @param   written     producer total as seen by the consumer
+ *          read        new consumer total
+ *
+ * @return  -
+ */
+void
+WaitableCircularBuffer::release( uint32_t written, uint32_t read ) {
+    _read.store( read, std::memory_order_seq_cst );
+    if ( _spaceWaiters.load( std::memory_order_seq_cst ) ) {
+        if ( _ByteArray.size() - ( written - read ) >= _spaceWanted.load( std::memory_order_relaxed ) ) {
+            futexWake( &_read );
+        }
+    }
+    if ( ( 0 <= _eventFd ) && ( written == read ) && !_armed.load( std::memory_order_relaxed ) ) {
+        //drained: reset the counter and arm, then close the race with the producer
+        uint64_t value;
+        if ( ::read( _eventFd, &value, sizeof( value ) ) ) {}
+        _armed.store( true, std::memory_order_seq_cst );
+        if ( _written.load( std::memory_order_seq_cst ) != read &&
+             _armed.exchange( false, std::memory_order_seq_cst ) ) {
+            uint64_t one = 1;
+            if ( ::write( _eventFd, &one, sizeof( one ) ) ) {}
+        }
+    }
+}
+
+#endif // __linux__
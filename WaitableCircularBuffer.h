@@ -0,0 +1,88 @@
+/**
+ * @file    WaitableCircularBuffer.h
+ *
+ * @brief   Declaration of class WaitableCircularBuffer
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _WaitableCircularBuffer_H_
+#define _WaitableCircularBuffer_H_
+
+#if defined( __linux__ )
+
+#include <stdint.h>
+#include <atomic>
+
+#include "ByteArray.h"
+
+/**
+ * @brief   The WaitableCircularBuffer class is a single producer, single consumer
+ *          byte ring where the consumer may sleep until data arrives and the
+ *          producer may sleep until space is freed.
+ *          Unlike CircularBuffer it never overwrites unread data.
+ *          Futex wakeups are issued only when the other side is parked, the
+ *          eventfd is signalled only on empty -> non-empty transitions.
+ */
+
+class WaitableCircularBuffer {
+    public:
+
+                        WaitableCircularBuffer( uint16_t size, bool withEventFd = false );
+                       ~WaitableCircularBuffer( void );
+
+                        WaitableCircularBuffer( const WaitableCircularBuffer& other ) = delete;
+        WaitableCircularBuffer& operator = ( const WaitableCircularBuffer& other ) = delete;
+
+        uint16_t        count(  void ) const;
+        uint16_t        size(   void ) const;
+        uint16_t        space(  void ) const;
+
+        bool            isEmpty( void ) const;
+        bool            isFull( void ) const;
+
+        bool            put(    uint8_t abyte );
+        uint16_t        put(    const uint8_t* data, uint16_t n );
+
+        uint8_t         get(    void );
+        uint16_t        get(    uint8_t* data, uint16_t n );
+
+        bool            waitForData(  uint16_t minBytes = 1, int32_t timeoutMs = -1 );
+        bool            waitForSpace( uint16_t n = 1,        int32_t timeoutMs = -1 );
+
+        int             eventFd( void ) const;
+
+    private:
+
+        void            publish( uint32_t written, uint32_t read );
+        void            release( uint32_t written, uint32_t read );
+
+        //<! storage, _size is the ring size
+        ByteArray                   _ByteArray;
+        //<! eventfd for epoll loops, -1 if not requested
+        int                         _eventFd        = -1;
+
+        //producer side
+        alignas( 64 )
+        std::atomic<uint32_t>       _written;       //futex word, total bytes put
+        uint16_t                    _head           = 0;
+        std::atomic<uint32_t>       _spaceWaiters;
+        std::atomic<uint32_t>       _spaceWanted;
+
+        //consumer side
+        alignas( 64 )
+        std::atomic<uint32_t>       _read;          //futex word, total bytes taken
+        uint16_t                    _tail           = 0;
+        std::atomic<uint32_t>       _dataWaiters;
+        std::atomic<uint32_t>       _dataWanted;
+        std::atomic<bool>           _armed;         //eventfd is drained and may fire
+};
+
+#endif // __linux__
+
+#endif // _WaitableCircularBuffer_H_
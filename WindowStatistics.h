@@ -0,0 +1,242 @@
+/**
+ * @file    WindowStatistics.h
+ *
+ * @brief   Declaration of class template WindowStatistics
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _WindowStatistics_H_
+#define _WindowStatistics_H_
+
+#include <stdint.h>
+#include <cmath>
+
+#include "TypedCircularBuffer.h"
+
+/**
+ * @brief   The WindowStatistics class template keeps sum, mean, variance, min and max
+ *          of the samples held in an attached TypedCircularBuffer, updated in O(1)
+ *          per push and pop: running sum and Welford mean/variance, monotonic
+ *          deques for min/max. The window is the ring itself: when it is full,
+ *          push evicts the oldest sample and its contribution is subtracted.
+ *          Samples must be pushed and popped through WindowStatistics.
+ */
+
+template < typename T >
+
+class WindowStatistics {
+
+public:
+    //attach to a ring, samples already stored in it are taken over
+    WindowStatistics( TypedCircularBuffer<T>& ring ) :
+        _ring( ring ),
+        _min( ring.size() ),
+        _max( ring.size() ) {
+        sync();
+    }
+
+    //add a sample, when the window is full the oldest one is evicted first
+    void push( const T& item ) {
+        if ( 0 == _ring.size() ) {
+            return;                                 //the ring keeps nothing, neither do we
+        }
+        if ( _ring.isFull() ) {
+            evict( _ring.at( (uint16_t)0 ) );
+        }
+        _ring.push( item );
+        add( item );
+    }
+
+    void push( const T* items, uint16_t n ) {
+        for ( uint16_t i = 0; i < n; ++i ) {
+            push( items[i] );
+        }
+    }
+
+    //remove and return the oldest sample, T() if empty
+    T pop() {
+        if ( _ring.isEmpty() ) {
+            return T();
+        }
+        T item = _ring.pop();
+        evict( item );
+        return item;
+    }
+
+    //samples in the window
+    uint16_t count() const {
+        return _n;
+    }
+
+    double sum() const {
+        return _sum;
+    }
+
+    double mean() const {
+        return _mean;
+    }
+
+    //population variance
+    double variance() const {
+        return _n ? ( _m2 > 0.0 ? _m2 / _n : 0.0 ) : 0.0;
+    }
+
+    //sample variance
+    double sampleVariance() const {
+        return ( _n > 1 ) ? ( _m2 > 0.0 ? _m2 / ( _n - 1 ) : 0.0 ) : 0.0;
+    }
+
+    double stddev() const {
+        return std::sqrt( variance() );
+    }
+
+    //smallest sample in the window, T() if empty
+    T min() const {
+        return _min.isEmpty() ? T() : _min.front().value;
+    }
+
+    //largest sample in the window, T() if empty
+    T max() const {
+        return _max.isEmpty() ? T() : _max.front().value;
+    }
+
+    //rebuild everything from the ring contents in O(N),
+    //for a ring that was changed behind our back or to shed rounding drift
+    void sync() {
+        _n      = 0;
+        _sum    = 0.0;
+        _mean   = 0.0;
+        _m2     = 0.0;
+        _pushed = 0;
+        _min.clear();
+        _max.clear();
+        for ( uint16_t i = 0; i < _ring.count(); ++i ) {
+            add( _ring.at( i ) );
+        }
+    }
+
+private:
+    //sample with its push sequence number
+    struct Entry {
+        T           value;
+        uint32_t    seq;
+    };
+
+    //fixed capacity deque, never holds more entries than the window
+    class MonoDeque {
+    public:
+        MonoDeque( uint16_t size ) :
+            _size( size ? size : 1 ), _count( 0 ), _front( 0 ), _data( new Entry[_size] ) {}
+
+        ~MonoDeque() {
+            delete[] _data;
+        }
+
+        MonoDeque( const MonoDeque& other ) = delete;
+        MonoDeque& operator = ( const MonoDeque& other ) = delete;
+
+        bool isEmpty() const {
+            return 0 == _count;
+        }
+
+        void clear() {
+            _count = 0;
+            _front = 0;
+        }
+
+        const Entry& front() const {
+            return _data[_front];
+        }
+
+        const Entry& back() const {
+            return _data[index( _count - 1 )];
+        }
+
+        void popFront() {
+            if ( ++_front >= _size ) {
+                _front = 0;
+            }
+            --_count;
+        }
+
+        void popBack() {
+            --_count;
+        }
+
+        void pushBack( const Entry& entry ) {
+            _data[index( _count )] = entry;
+            ++_count;
+        }
+
+    private:
+        uint16_t index( uint16_t i ) const {
+            uint32_t pos = (uint32_t)_front + i;
+            return (uint16_t)( ( pos >= _size ) ? pos - _size : pos );
+        }
+
+        uint16_t        _size;
+        uint16_t        _count;
+        uint16_t        _front;
+        Entry* const    _data;
+    };
+
+    void add( const T& item ) {
+        double x = (double)item;
+        ++_n;
+        _sum += x;
+        double delta = x - _mean;
+        _mean += delta / _n;
+        _m2   += delta * ( x - _mean );
+
+        Entry entry = { item, _pushed++ };
+        while ( !_max.isEmpty() && !( item < _max.back().value ) ) {
+            _max.popBack();
+        }
+        _max.pushBack( entry );
+        while ( !_min.isEmpty() && !( _min.back().value < item ) ) {
+            _min.popBack();
+        }
+        _min.pushBack( entry );
+    }
+
+    //item is the oldest sample of the window
+    void evict( const T& item ) {
+        uint32_t seq = _pushed - _n;
+        if ( 1 == _n ) {
+            _n    = 0;
+            _sum  = 0.0;
+            _mean = 0.0;
+            _m2   = 0.0;
+        } else if ( _n ) {
+            double x = (double)item;
+            --_n;
+            _sum -= x;
+            double delta = x - _mean;
+            _mean -= delta / _n;
+            _m2   -= delta * ( x - _mean );
+        }
+        if ( !_max.isEmpty() && ( seq == _max.front().seq ) ) {
+            _max.popFront();
+        }
+        if ( !_min.isEmpty() && ( seq == _min.front().seq ) ) {
+            _min.popFront();
+        }
+    }
+
+    TypedCircularBuffer<T>& _ring;
+    uint16_t                _n      = 0;
+    uint32_t                _pushed = 0;    //sequence number of the next sample
+    double                  _sum    = 0.0;
+    double                  _mean   = 0.0;
+    double                  _m2     = 0.0;
+    MonoDeque               _min;
+    MonoDeque               _max;
+};
+
+#endif // _WindowStatistics_H_
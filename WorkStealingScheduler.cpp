@@ -0,0 +1,365 @@
+/**
+ * @file    WorkStealingScheduler.cpp
+ *
+ * @brief   Implementation of the WorkStealingScheduler class
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#if defined( __linux__ )
+
+#include "WorkStealingScheduler.h"
+#include "Futex.h"
+
+
+//how many empty rounds a worker spins before it goes to sleep
+#define WORKER_SPIN_ROUNDS  64
+//sleeping workers look around at least this often
+#define WORKER_SLEEP_MS     10
+
+
+//the worker the current thread is, if any
+static thread_local WorkStealingScheduler*  tlsScheduler    = nullptr;
+static thread_local void*                   tlsWorker       = nullptr;
+
+
+//Constructor, workers are created by Start()
+WorkStealingScheduler::WorkStealingScheduler( uint8_t workers ) :
+    _workerCount( workers ), _running( false ),
+    _epoch( 0 ), _sleepers( 0 ), _nextInbox( 0 ) {
+    if ( 0 == _workerCount ) {
+        unsigned cores = std::thread::hardware_concurrency();
+        _workerCount = !cores ? 1 : ( ( cores < 255 ) ? (uint8_t)cores : 255 );
+    }
+}
+
+//Destructor, pipelines are owned by the caller
+WorkStealingScheduler::~WorkStealingScheduler() {
+    Stop();
+    for ( auto task : _tasks ) {
+        delete task->ingress;
+        delete task;
+    }
+}
+
+
+/* Setup */
+
+//Register a pipeline, only while stopped
+int16_t WorkStealingScheduler::AddPipeline( Pipeline* pPipeline, uint16_t ingressSize ) {
+    if ( !pPipeline || _running.load() || _tasks.size() >= INT16_MAX ) {
+        return -1;
+    }
+    ByteArray* frontEnd = pPipeline->getFrontEnd();
+    if ( !ingressSize && frontEnd ) {
+        ingressSize = frontEnd->size();
+    }
+    Task* task = new Task;
+    task->pipeline = pPipeline;
+    task->state.store( PARKED );
+    task->lastStatus.store( StatusCode::OK );
+    task->ingress = ( frontEnd && ingressSize ) ? new WaitableCircularBuffer( ingressSize ) : nullptr;
+    task->next = nullptr;
+    _tasks.push_back( task );
+    return (int16_t)( _tasks.size() - 1 );
+}
+
+//Create the workers, every pipeline starts queued
+StatusCode WorkStealingScheduler::Start( void ) {
+    if ( _running.load() || _tasks.empty() ) {
+        return StatusCode::ERROR;
+    }
+    _capacity = 2;
+    while ( _capacity < _tasks.size() ) {
+        _capacity <<= 1;
+    }
+    _workers = new Worker[_workerCount];
+    for ( uint8_t i = 0; i < _workerCount; ++i ) {
+        Worker* worker = &_workers[i];
+        worker->top.store( 0 );
+        worker->bottom.store( 0 );
+        worker->buffer = new std::atomic<Task*>[_capacity];
+        worker->inbox.store( nullptr );
+        worker->runs.store( 0 );
+        worker->steals.store( 0 );
+    }
+    //deal the pipelines out, nobody runs yet
+    for ( uint16_t i = 0; i < _tasks.size(); ++i ) {
+        _tasks[i]->state.store( QUEUED );
+        push( &_workers[i % _workerCount], _tasks[i] );
+    }
+    _running.store( true );
+    for ( uint8_t i = 0; i < _workerCount; ++i ) {
+        _workers[i].thread = std::thread( &WorkStealingScheduler::run, this, i );
+    }
+    return StatusCode::OK;
+}
+
+//Stop and join the workers, pipelines keep their state and counters add up
+void WorkStealingScheduler::Stop( void ) {
+    if ( !_workers ) {
+        return;
+    }
+    _running.store( false );
+    _epoch.fetch_add( 1 );
+    futexWake( &_epoch );
+    for ( uint8_t i = 0; i < _workerCount; ++i ) {
+        if ( _workers[i].thread.joinable() ) {
+            _workers[i].thread.join();
+        }
+        delete[] _workers[i].buffer;
+        _runs   += _workers[i].runs.load();
+        _steals += _workers[i].steals.load();
+    }
+    delete[] _workers;
+    _workers = nullptr;
+    for ( auto task : _tasks ) {
+        task->state.store( PARKED );
+    }
+}
+
+
+/* Wakeups */
+
+//Input for pipeline id through its ring, safe while a worker runs it
+uint16_t WorkStealingScheduler::Sink( uint16_t id, const uint8_t* data, uint16_t size ) {
+    if ( id >= _tasks.size() || !_tasks[id]->ingress || !data ) {
+        return 0;
+    }
+    uint16_t n = _tasks[id]->ingress->put( data, size );
+    if ( n ) {
+        notify( id );
+    }
+    return n;
+}
+
+//Input arrived for pipeline id: queue it if parked, flag it if running
+void WorkStealingScheduler::notify( uint16_t id ) {
+    if ( id >= _tasks.size() || !_workers ) {
+        return;
+    }
+    Task* task = _tasks[id];
+    //the input written before must be seen by a run starting after this load,
+    //pairs with the fence in execute(), else both sides can miss each other
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    uint8_t state = task->state.load( std::memory_order_seq_cst );
+    for ( ;; ) {
+        if ( PARKED == state ) {
+            if ( task->state.compare_exchange_weak( state, QUEUED, std::memory_order_acq_rel ) ) {
+                if ( this == tlsScheduler && tlsWorker ) {
+                    push( (Worker*)tlsWorker, task );
+                } else {
+                    post( &_workers[_nextInbox.fetch_add( 1, std::memory_order_relaxed ) % _workerCount], task );
+                }
+                wakeOne();
+                return;
+            }
+        } else if ( RUNNING == state ) {
+            if ( task->state.compare_exchange_weak( state, NOTIFIED, std::memory_order_acq_rel ) ) {
+                return;
+            }
+        } else {
+            return;                     //QUEUED or NOTIFIED, it will run anyway
+        }
+    }
+}
+
+//Push into a worker's inbox from any thread
+void WorkStealingScheduler::post( Worker* pWorker, Task* pTask ) {
+    Task* head = pWorker->inbox.load( std::memory_order_relaxed );
+    do {
+        pTask->next = head;
+    } while ( !pWorker->inbox.compare_exchange_weak( head, pTask,
+                std::memory_order_release, std::memory_order_relaxed ) );
+}
+
+//Wake the sleepers only if there are any, no syscall while everybody is busy
+void WorkStealingScheduler::wakeOne( void ) {
+    if ( _sleepers.load( std::memory_order_seq_cst ) ) {
+        _epoch.fetch_add( 1, std::memory_order_seq_cst );
+        //inbox items are not stealable, so wake them all
+        futexWake( &_epoch );
+    }
+}
+
+
+/* Chase-Lev deque */
+
+//Owner only: add at the bottom
+void WorkStealingScheduler::push( Worker* pWorker, Task* pTask ) {
+    int64_t bottom = pWorker->bottom.load( std::memory_order_relaxed );
+    pWorker->buffer[bottom & ( _capacity - 1 )].store( pTask, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+    pWorker->bottom.store( bottom + 1, std::memory_order_relaxed );
+}
+
+//Anybody: take from the top, the owner too so its pipelines go round robin
+WorkStealingScheduler::Task* WorkStealingScheduler::steal( Worker* pWorker ) {
+    int64_t top = pWorker->top.load( std::memory_order_acquire );
+    std::atomic_thread_fence( std::memory_order_seq_cst );
+    int64_t bottom = pWorker->bottom.load( std::memory_order_acquire );
+    if ( top < bottom ) {
+        Task* task = pWorker->buffer[top & ( _capacity - 1 )].load( std::memory_order_relaxed );
+        if ( pWorker->top.compare_exchange_strong( top, top + 1,
+                std::memory_order_seq_cst, std::memory_order_relaxed ) ) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+bool WorkStealingScheduler::hasWork( Worker* pWorker ) const {
+    if ( pWorker->inbox.load( std::memory_order_seq_cst ) ) {
+        return true;
+    }
+    for ( uint8_t i = 0; i < _workerCount; ++i ) {
+        if ( _workers[i].top.load( std::memory_order_seq_cst ) <
+             _workers[i].bottom.load( std::memory_order_seq_cst ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/* Worker thread */
+
+void WorkStealingScheduler::run( uint8_t index ) {
+
+    Worker*  self = &_workers[index];
+    uint32_t idle = 0;
+
+    tlsScheduler = this;
+    tlsWorker    = self;
+
+    while ( _running.load( std::memory_order_relaxed ) ) {
+
+        //adopt what others woke up for us
+        Task* list = self->inbox.exchange( nullptr, std::memory_order_acquire );
+        while ( list ) {
+            Task* next = list->next;
+            push( self, list );
+            list = next;
+        }
+
+        Task* task = steal( self );
+        for ( uint8_t k = 1; !task && k < _workerCount; ++k ) {
+            task = steal( &_workers[( index + k ) % _workerCount] );
+            if ( task ) {
+                self->steals.fetch_add( 1, std::memory_order_relaxed );
+            }
+        }
+
+        if ( task ) {
+            execute( self, task );
+            idle = 0;
+            continue;
+        }
+
+        if ( ++idle < WORKER_SPIN_ROUNDS ) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        //announce, look once more, sleep until something is posted
+        uint32_t epoch = _epoch.load( std::memory_order_seq_cst );
+        _sleepers.fetch_add( 1, std::memory_order_seq_cst );
+        if ( !hasWork( self ) && _running.load() ) {
+            futexWait( &_epoch, epoch, WORKER_SLEEP_MS );
+        }
+        _sleepers.fetch_sub( 1, std::memory_order_seq_cst );
+    }
+
+    tlsScheduler = nullptr;
+    tlsWorker    = nullptr;
+}
+
+//Run one processAll() and decide between requeue and park
+void WorkStealingScheduler::execute( Worker* pWorker, Task* pTask ) {
+
+    pTask->state.store( RUNNING, std::memory_order_seq_cst );
+    std::atomic_thread_fence( std::memory_order_seq_cst );     //before the input is read, see notify()
+    pWorker->runs.fetch_add( 1, std::memory_order_relaxed );
+
+    //ingress ring -> front end free space
+    ByteArray* frontEnd = pTask->pipeline->getFrontEnd();
+    if ( pTask->ingress && frontEnd->data() ) {
+        uint16_t n = pTask->ingress->get( frontEnd->data() + frontEnd->count(),
+                                          frontEnd->size() - frontEnd->count() );
+        frontEnd->update_count( frontEnd->count() + n );
+    }
+
+    StatusCode status = pTask->pipeline->processAll();
+    pTask->lastStatus.store( status, std::memory_order_relaxed );
+
+    bool more;
+    switch ( status ) {
+    case StatusCode::OK:            //quantum finished, continue later
+    case StatusCode::REPEAT:
+        more = true;
+        break;
+    case StatusCode::NEXT:          //went through, more only if input is left
+        more = frontEnd && frontEnd->count();
+        break;
+    default:                        //PENDING, ERROR, PARTIAL: wait for notify()
+        more = false;
+        break;
+    }
+    if ( StatusCode::NEXT == status || StatusCode::PENDING == status ) {
+        //ring data the front end had no room for, it has now
+        more = more || ( pTask->ingress && !pTask->ingress->isEmpty()
+                                        && frontEnd->count() < frontEnd->size() );
+    }
+
+    if ( !more ) {
+        uint8_t expected = RUNNING;
+        if ( pTask->state.compare_exchange_strong( expected, PARKED, std::memory_order_acq_rel ) ) {
+            return;
+        }
+        //NOTIFIED while running: input came, go again
+    }
+    pTask->state.store( QUEUED, std::memory_order_release );
+    push( pWorker, pTask );
+    wakeOne();
+}
+
+
+/* Other utility functions */
+
+uint16_t WorkStealingScheduler::getPipelineCount( void ) const {
+    return _tasks.size();
+}
+
+uint8_t WorkStealingScheduler::getWorkerCount( void ) const {
+    return _workerCount;
+}
+
+StatusCode WorkStealingScheduler::getLastStatus( uint16_t id ) const {
+    if ( id < _tasks.size() ) {
+        return _tasks[id]->lastStatus.load( std::memory_order_relaxed );
+    }
+    return StatusCode::ERROR;
+}
+
+uint64_t WorkStealingScheduler::getRuns( void ) const {
+    uint64_t runs = _runs;
+    for ( uint8_t i = 0; _workers && i < _workerCount; ++i ) {
+        runs += _workers[i].runs.load( std::memory_order_relaxed );
+    }
+    return runs;
+}
+
+uint64_t WorkStealingScheduler::getSteals( void ) const {
+    uint64_t steals = _steals;
+    for ( uint8_t i = 0; _workers && i < _workerCount; ++i ) {
+        steals += _workers[i].steals.load( std::memory_order_relaxed );
+    }
+    return steals;
+}
+
+#endif // __linux__
@@ -0,0 +1,120 @@
+/**
+ * @file    WorkStealingScheduler.h
+ *
+ * @brief   Declaration of WorkStealingScheduler
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#ifndef _WORKSTEALINGSCHEDULER_H_
+#define _WORKSTEALINGSCHEDULER_H_
+
+#if defined( __linux__ )
+
+#include "Pipeline.h"
+#include "WaitableCircularBuffer.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+
+/*
+ * WorkStealingScheduler owns a set of Pipelines and runs processAll() of the
+ * ready ones on a pool of worker threads. Every worker has its own deque
+ * (Chase-Lev: the owner pushes at the bottom, anybody takes from the top,
+ * so the owner serves its pipelines round robin) and an inbox for pipelines
+ * woken up by other threads. Idle workers steal from the others.
+ * A pipeline returning PENDING (or NEXT with an empty front end, or an error)
+ * is parked and costs nothing until notify() is called for it; OK and REPEAT
+ * keep it queued. A pipeline is only ever run by one worker at a time.
+ *
+ * While the scheduler runs, the front end of a pipeline belongs to the
+ * worker running it, writing it from outside races processAll(). Input goes
+ * in by Sink() instead: into an SPSC ring of the pipeline (one thread sinks
+ * per pipeline), the worker moves it to the front end before every run.
+ * Write the front end directly only while stopped; notify() alone is for
+ * pipelines that fetch their input themselves, e.g. read a fd.
+ *
+ * There is no global lock: deques, inboxes and task states are lock free,
+ * idle workers sleep on a futex that is only touched when somebody sleeps.
+ */
+
+class WorkStealingScheduler {
+
+public:
+    WorkStealingScheduler( uint8_t workers = 0 );               //0: one per core
+    ~WorkStealingScheduler();
+
+    int16_t    AddPipeline( Pipeline* pPipeline,                //id, -1 on error
+                            uint16_t  ingressSize = 0 );        //ring for Sink(), 0: front end size
+    StatusCode Start( void );
+    void       Stop( void );
+
+    uint16_t   Sink( uint16_t id, const uint8_t* data, uint16_t size );    //bytes taken, notifies
+    void       notify( uint16_t id );                           //input arrived
+
+    uint16_t   getPipelineCount( void ) const;
+    uint8_t    getWorkerCount( void ) const;
+    StatusCode getLastStatus( uint16_t id ) const;
+    uint64_t   getRuns( void ) const;
+    uint64_t   getSteals( void ) const;
+
+private:
+
+    enum TaskState : uint8_t {
+        PARKED,         //in no queue, waits for notify()
+        QUEUED,         //in a deque or an inbox
+        RUNNING,        //a worker is in processAll()
+        NOTIFIED        //running, and notify() came meanwhile
+    };
+
+    struct Task {
+        Pipeline*               pipeline;
+        std::atomic<uint8_t>    state;
+        std::atomic<StatusCode> lastStatus;
+        WaitableCircularBuffer* ingress;        //Sink() -> front end, nullptr without one
+        Task*                   next;           //inbox link
+    };
+
+    struct alignas( 64 ) Worker {
+        //Chase-Lev deque, capacity covers all tasks so it never grows
+        std::atomic<int64_t>    top;
+        std::atomic<int64_t>    bottom;
+        std::atomic<Task*>*     buffer;
+        //lock free inbox, pushed by anybody, taken all at once by the owner
+        std::atomic<Task*>      inbox;
+        std::atomic<uint64_t>   runs;
+        std::atomic<uint64_t>   steals;
+        std::thread             thread;
+    };
+
+    void       run( uint8_t index );
+    void       execute( Worker* pWorker, Task* pTask );
+    void       push( Worker* pWorker, Task* pTask );
+    Task*      steal( Worker* pWorker );
+    void       post( Worker* pWorker, Task* pTask );
+    void       wakeOne( void );
+    bool       hasWork( Worker* pWorker ) const;
+
+    uint8_t                 _workerCount;
+    uint32_t                _capacity       = 0;        //deque size, power of 2
+    std::atomic<bool>       _running;
+    std::atomic<uint32_t>   _epoch;                     //futex word for idle workers
+    std::atomic<uint32_t>   _sleepers;
+    std::atomic<uint32_t>   _nextInbox;
+    uint64_t                _runs           = 0;        //of the workers already stopped
+    uint64_t                _steals         = 0;
+
+    Worker*                 _workers        = nullptr;
+    std::vector<Task*>      _tasks;
+};
+
+#endif // __linux__
+
+#endif // _WORKSTEALINGSCHEDULER_H_
@@ -0,0 +1,88 @@
+/**
+ * @file    ParallelPipeBench.cpp
+ *
+ * @brief   Hex decoding of a stream by one Pipe against ParallelPipe
+ *          with 1..n threads
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ *          g++ -std=c++17 -O2 -pthread -I.. ParallelPipeBench.cpp ../ParallelPipe.cpp
+ *              ../Pipe.cpp ../ByteArray.cpp -o ParallelPipeBench
+ *          ./ParallelPipeBench [MB] [chunk] [max threads]
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "../ParallelPipe.h"
+
+
+static uint8_t nibble( uint8_t c ) {
+    return ( c <= '9' ) ? c - '0' : ( c | 0x20 ) - 'a' + 10;
+}
+
+//stateless stage: pairs of hex digits to bytes, an odd digit stays in the input
+static StatusCode hexDecode( ByteArray* pIn, ByteArray* pOut ) {
+    const uint8_t* in  = pIn->data();
+    uint8_t*       out = pOut->data() + pOut->count();
+    uint16_t pairs = pIn->count() / 2;
+    uint16_t space = pOut->size() - pOut->count();
+    if ( pairs > space ) {
+        pairs = space;
+    }
+    for ( uint16_t i = 0; i < pairs; ++i ) {
+        out[i] = ( nibble( in[2 * i] ) << 4 ) | nibble( in[2 * i + 1] );
+    }
+    pOut->update_count( pOut->count() + pairs );
+    memmove( pIn->data(), in + 2 * pairs, pIn->count() - 2 * pairs );
+    pIn->update_count( pIn->count() - 2 * pairs );
+    return pIn->count() ? StatusCode::PENDING : StatusCode::NEXT;
+}
+
+static uint8_t hex[60000];
+
+//MB/s of decoded output, total bytes go through 60000 byte inputs
+static double run( Pipe* pPipe, ByteArray* pIn, ByteArray* pOut, uint64_t total ) {
+    uint64_t done = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while ( done < total ) {
+        pIn->clear();
+        pIn->append( hex, sizeof( hex ) );
+        while ( pIn->count() ) {
+            pPipe->process();
+            done += pOut->count();
+            pOut->clear();
+        }
+    }
+    double s = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    return done / s / 1e6;
+}
+
+int main( int argc, char** argv ) {
+    uint64_t total   = ( ( argc > 1 ) ? atoi( argv[1] ) : 200 ) * 1000000ull;
+    uint16_t chunk   = ( argc > 2 ) ? atoi( argv[2] ) : 1024;
+    unsigned threads = ( argc > 3 ) ? atoi( argv[3] ) : std::thread::hardware_concurrency();
+    if ( chunk & 1 ) {
+        ++chunk;                        //whole pairs in every chunk
+    }
+    for ( size_t i = 0; i < sizeof( hex ); ++i ) {
+        hex[i] = "0123456789abcdef"[rand() & 15];
+    }
+
+    ByteArray in( (uint16_t)sizeof( hex ) ), out( (uint16_t)( sizeof( hex ) / 2 ) );
+    Pipe serial( &in, hexDecode, &out );
+    printf( "Pipe                  %8.1f MB/s\r\n", run( &serial, &in, &out, total ) );
+    for ( unsigned t = 1; t <= threads && t <= 255; t *= 2 ) {
+        ParallelPipe parallel( &in, hexDecode, &out, chunk, t );
+        printf( "ParallelPipe %3u thr  %8.1f MB/s\r\n", t, run( &parallel, &in, &out, total ) );
+    }
+    return 0;
+}
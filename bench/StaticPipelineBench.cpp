@@ -0,0 +1,113 @@
+/**
+ * @file    StaticPipelineBench.cpp
+ *
+ * @brief   Throughput of Pipeline::processAll against StaticPipeline
+ *          with the same 4 light stages
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ *          g++ -std=c++17 -O2 -I.. StaticPipelineBench.cpp ../Pipeline.cpp ../PipelineTrace.cpp ../BufferPool.cpp ../Pipe.cpp
+ *              ../ByteArray.cpp -o StaticPipelineBench
+ *          ./StaticPipelineBench [buffer size] [MB]
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../Pipeline.h"
+#include "../StaticPipeline.h"
+
+
+//light stages, per stage overhead dominates
+static inline StatusCode move( ByteArray* pIn, ByteArray* pOut, uint8_t key ) {
+    uint16_t n = pIn->count();
+    uint16_t space = pOut->size() - pOut->count();
+    if ( n > space ) {
+        n = space;
+    }
+    uint8_t* src = pIn->data();
+    uint8_t* dst = pOut->data() + pOut->count();
+    for ( uint16_t i = 0; i < n; ++i ) {
+        dst[i] = (uint8_t)( src[i] + key );
+    }
+    std::memmove( src, src + n, pIn->count() - n );
+    pIn->update_count( pIn->count() - n );
+    pOut->update_count( pOut->count() + n );
+    return StatusCode::NEXT;
+}
+
+static StatusCode stage1( ByteArray* pIn, ByteArray* pOut ) { return move( pIn, pOut, 1 ); }
+static StatusCode stage2( ByteArray* pIn, ByteArray* pOut ) { return move( pIn, pOut, 3 ); }
+static StatusCode stage3( ByteArray* pIn, ByteArray* pOut ) { return move( pIn, pOut, 5 ); }
+static StatusCode stage4( ByteArray* pIn, ByteArray* pOut ) { return move( pIn, pOut, 7 ); }
+
+
+//feed chunk bytes, processAll, take the back end, until total bytes went through
+template < typename P >
+static double drive( P& pipeline, ByteArray* frontEnd, ByteArray* backEnd,
+                     uint16_t chunk, uint32_t total, uint32_t* pChecksum ) {
+    uint32_t sent = 0, received = 0, checksum = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while ( received < total ) {
+        uint16_t n = frontEnd->size() - frontEnd->count();
+        if ( n > chunk ) {
+            n = chunk;
+        }
+        if ( n > total - sent ) {
+            n = total - sent;
+        }
+        std::memset( frontEnd->data() + frontEnd->count(), (uint8_t)sent, n );
+        frontEnd->update_count( frontEnd->count() + n );
+        sent += n;
+        pipeline.processAll();
+        for ( uint16_t i = 0; i < backEnd->count(); ++i ) {
+            checksum += backEnd->data()[i];
+        }
+        received += backEnd->count();
+        backEnd->update_count( 0 );
+    }
+    double s = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    *pChecksum = checksum;
+    return total / s / 1e6;
+}
+
+int main( int argc, char** argv ) {
+    int chunk       = ( argc > 1 ) ? atoi( argv[1] ) : 16;
+    uint32_t total  = ( ( argc > 2 ) ? atoi( argv[2] ) : 64 ) * 1000000u;
+    if ( chunk < 1 || chunk > 256 ) {
+        chunk = 16;
+    }
+
+    ByteArray* buffers[5];
+    Pipeline dynamicPipeline( (uint16_t)0 );
+    for ( uint8_t i = 0; i < 5; ++i ) {
+        buffers[i] = new ByteArray( (uint16_t)256 );
+    }
+    dynamicPipeline.AddProcessor( buffers[0], stage1, buffers[1] );
+    dynamicPipeline.AddProcessor( buffers[1], stage2, buffers[2] );
+    dynamicPipeline.AddProcessor( buffers[2], stage3, buffers[3] );
+    dynamicPipeline.AddProcessor( buffers[3], stage4, buffers[4] );
+
+    static StaticPipeline<256, stage1, stage2, stage3, stage4> staticPipeline;
+
+    uint32_t dynamicChecksum, staticChecksum;
+    double a = drive( dynamicPipeline, buffers[0], buffers[4], chunk, total, &dynamicChecksum );
+    double b = drive( staticPipeline, staticPipeline.getFrontEnd(), staticPipeline.getBackEnd(),
+                      chunk, total, &staticChecksum );
+
+    printf( "chunk  Pipeline MB/s  StaticPipeline MB/s  checksums\r\n" );
+    printf( "%5d  %13.1f  %19.1f  %s\r\n", chunk, a, b,
+            ( dynamicChecksum == staticChecksum ) ? "equal" : "DIFFER" );
+
+    for ( uint8_t i = 0; i < 5; ++i ) {
+        delete buffers[i];
+    }
+    return 0;
+}
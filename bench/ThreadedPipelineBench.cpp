@@ -0,0 +1,145 @@
+/**
+ * @file    ThreadedPipelineBench.cpp
+ *
+ * @brief   Throughput of Pipeline::processAll against ThreadedPipeline
+ *          with 1..N synthetic stages
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ *          g++ -std=c++17 -O2 -I.. ThreadedPipelineBench.cpp ../ThreadedPipeline.cpp
+ *              ../WaitableCircularBuffer.cpp ../Pipeline.cpp ../PipelineTrace.cpp ../BufferPool.cpp ../Pipe.cpp ../ByteArray.cpp
+ *              -pthread -o ThreadedPipelineBench
+ *          ./ThreadedPipelineBench [max stages] [MB]
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "../ThreadedPipeline.h"
+
+
+//synthetic stage: some work per byte, moves everything that fits to the output
+static StatusCode work( ByteArray* pIn, ByteArray* pOut ) {
+    uint16_t n = pIn->count();
+    uint16_t space = pOut->size() - pOut->count();
+    if ( n > space ) {
+        n = space;
+    }
+    if ( 0 == n ) {
+        return pIn->count() ? StatusCode::OK : StatusCode::PENDING;
+    }
+    uint8_t* src = pIn->data();
+    uint8_t* dst = pOut->data() + pOut->count();
+    for ( uint16_t i = 0; i < n; ++i ) {
+        uint32_t x = src[i];
+        for ( int k = 0; k < 16; ++k ) {
+            x = x * 1103515245u + 12345u;
+        }
+        dst[i] = (uint8_t)( x >> 24 );
+    }
+    std::memmove( src, src + n, pIn->count() - n );
+    pIn->update_count( pIn->count() - n );
+    pOut->update_count( pOut->count() + n );
+    return StatusCode::NEXT;
+}
+
+//one pipeline of `pipes` work stages with their own buffers
+static Pipeline* buildPipeline( uint8_t pipes, ByteArray** buffers ) {
+    Pipeline* pipeline = new Pipeline( (uint16_t)0 );
+    for ( uint8_t i = 0; i <= pipes; ++i ) {
+        buffers[i] = new ByteArray( (uint16_t)1024 );
+    }
+    for ( uint8_t i = 0; i < pipes; ++i ) {
+        pipeline->AddProcessor( buffers[i], work, buffers[i + 1] );
+    }
+    return pipeline;
+}
+
+static double sequential( uint8_t stages, uint32_t total ) {
+    ByteArray* buffers[33];
+    Pipeline* pipeline = buildPipeline( stages, buffers );
+    ByteArray* frontEnd = buffers[0];
+    ByteArray* backEnd  = buffers[stages];
+    uint32_t sent = 0, received = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while ( received < total ) {
+        if ( sent < total ) {
+            uint16_t n = frontEnd->size() - frontEnd->count();
+            if ( n > total - sent ) {
+                n = total - sent;
+            }
+            std::memset( frontEnd->data() + frontEnd->count(), (uint8_t)sent, n );
+            frontEnd->update_count( frontEnd->count() + n );
+            sent += n;
+        }
+        pipeline->processAll();
+        received += backEnd->count();
+        backEnd->clear();
+    }
+    double s = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    delete pipeline;
+    for ( uint8_t i = 0; i <= stages; ++i ) {
+        delete buffers[i];
+    }
+    return total / s / 1e6;
+}
+
+static double threaded( uint8_t stages, uint32_t total ) {
+    ByteArray* buffers[32][2];
+    Pipeline*  pipelines[32];
+    ThreadedPipeline threadedPipeline( 4096 );
+    unsigned cpus = std::thread::hardware_concurrency();
+    for ( uint8_t i = 0; i < stages; ++i ) {
+        pipelines[i] = buildPipeline( 1, buffers[i] );
+        threadedPipeline.AddStage( pipelines[i], cpus > 1 ? (int)( i % cpus ) : -1 );
+    }
+    uint8_t chunk[1024];
+    uint32_t sent = 0, received = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    threadedPipeline.Start();
+    while ( received < total ) {
+        uint16_t accepted = 0;
+        if ( sent < total ) {
+            uint16_t n = sizeof( chunk );
+            if ( n > total - sent ) {
+                n = total - sent;
+            }
+            std::memset( chunk, (uint8_t)sent, n );
+            threadedPipeline.Sink( chunk, n, &accepted );
+            sent += accepted;
+        }
+        //block on the output only when the input is full or done
+        received += threadedPipeline.Drain( chunk, sizeof( chunk ), accepted ? 0 : 1 );
+    }
+    double s = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    threadedPipeline.Stop();
+    for ( uint8_t i = 0; i < stages; ++i ) {
+        delete pipelines[i];
+        delete buffers[i][0];
+        delete buffers[i][1];
+    }
+    return total / s / 1e6;
+}
+
+int main( int argc, char** argv ) {
+    int stages      = ( argc > 1 ) ? atoi( argv[1] ) : 4;
+    uint32_t total  = ( ( argc > 2 ) ? atoi( argv[2] ) : 16 ) * 1000000u;
+    if ( stages < 1 || stages > 32 ) {
+        stages = 4;
+    }
+    printf( "stages  sequential MB/s  threaded MB/s\r\n" );
+    for ( int k = 1; k <= stages; ++k ) {
+        double a = sequential( k, total );
+        double b = threaded( k, total );
+        printf( "%6d  %15.1f  %13.1f\r\n", k, a, b );
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+/**
+ * @file    UringBench.cpp
+ *
+ * @brief   Ingestion from many fds into Pipelines: SinkFromFd() and write()
+ *          per fd against one UringIO, over socketpairs or pipes
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ *          g++ -std=c++17 -O2 -I.. UringBench.cpp ../UringIO.cpp ../Pipeline.cpp
+ *              ../PipelineTrace.cpp ../BufferPool.cpp ../Pipe.cpp ../ByteArray.cpp -o UringBench
+ *          ./UringBench [fds] [MB per fd] [pipe]
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../UringIO.h"
+
+
+//synthetic stage: moves everything that fits to the output
+static StatusCode pass( ByteArray* pIn, ByteArray* pOut ) {
+    if ( !pIn->count() ) {
+        return StatusCode::PENDING;
+    }
+    uint16_t n = pOut->append( pIn->data(), pIn->count() );
+    memmove( pIn->data(), pIn->data() + n, pIn->count() - n );
+    pIn->update_count( pIn->count() - n );
+    return StatusCode::NEXT;
+}
+
+struct Lane {
+    int         writer;                 //bench side
+    int         reader;                 //pipeline side
+    ByteArray*  in;
+    ByteArray*  out;
+    Pipeline*   pipeline;
+    uint32_t    sent;
+};
+
+static int      nullFd;
+static uint8_t  chunk[4096];
+
+static void openLanes( Lane* lanes, int count, bool pipes ) {
+    for ( int i = 0; i < count; ++i ) {
+        int fds[2];
+        if ( pipes ) {
+            if ( pipe( fds ) ) {
+                exit( 1 );
+            }
+        } else if ( socketpair( AF_UNIX, SOCK_STREAM, 0, fds ) ) {
+            exit( 1 );
+        }
+        lanes[i].reader   = fds[0];
+        lanes[i].writer   = fds[1];
+        fcntl( fds[0], F_SETFL, O_NONBLOCK );
+        fcntl( fds[1], F_SETFL, O_NONBLOCK );
+        lanes[i].in       = new ByteArray( (uint16_t)8192 );
+        lanes[i].out      = new ByteArray( (uint16_t)8192 );
+        lanes[i].pipeline = new Pipeline( (uint16_t)0 );
+        lanes[i].pipeline->AddProcessor( lanes[i].in, pass, lanes[i].out );
+        lanes[i].sent     = 0;
+    }
+}
+
+static void closeLanes( Lane* lanes, int count ) {
+    for ( int i = 0; i < count; ++i ) {
+        close( lanes[i].reader );
+        close( lanes[i].writer );
+        delete lanes[i].pipeline;
+        delete lanes[i].in;
+        delete lanes[i].out;
+    }
+}
+
+//the producer side, the same for both paths and not counted
+static bool produce( Lane* lanes, int count, uint32_t total ) {
+    bool more = false;
+    for ( int i = 0; i < count; ++i ) {
+        if ( lanes[i].sent < total ) {
+            uint32_t n = total - lanes[i].sent;
+            ssize_t  w = write( lanes[i].writer, chunk, ( n < sizeof( chunk ) ) ? n : sizeof( chunk ) );
+            if ( 0 < w ) {
+                lanes[i].sent += w;
+            }
+            more = true;
+        }
+    }
+    return more;
+}
+
+static double readWrite( int count, uint32_t total, bool pipes, uint64_t* pSyscalls ) {
+    Lane lanes[256];
+    openLanes( lanes, count, pipes );
+    uint64_t received = 0, syscalls = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while ( produce( lanes, count, total ) || received < (uint64_t)count * total ) {
+        for ( int i = 0; i < count; ++i ) {
+            lanes[i].pipeline->SinkFromFd( 1, lanes[i].reader );
+            lanes[i].pipeline->processAll();
+            ++syscalls;
+            if ( lanes[i].out->count() ) {
+                ssize_t w = write( nullFd, lanes[i].out->data(), lanes[i].out->count() );
+                ++syscalls;
+                if ( 0 < w ) {
+                    received += w;
+                    lanes[i].out->clear();
+                }
+            }
+        }
+    }
+    double s = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    closeLanes( lanes, count );
+    *pSyscalls = syscalls;
+    return received / s / 1e6;
+}
+
+static double uring( int count, uint32_t total, bool pipes, uint64_t* pSyscalls ) {
+    Lane lanes[256];
+    openLanes( lanes, count, pipes );
+    BufferPool pool( 4096, count * ( URING_PROVIDED_BUFFERS + 4 ) );
+    UringIO io( 1024 );
+    for ( int i = 0; i < count; ++i ) {
+        io.AddSource( lanes[i].reader, lanes[i].pipeline, 1, &pool );
+        io.AddSink( nullFd, lanes[i].pipeline, &pool );
+    }
+    if ( StatusCode::OK != io.Start() ) {
+        printf( "io_uring not available\r\n" );
+        exit( 1 );
+    }
+    uint64_t received = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    while ( produce( lanes, count, total ) || received < (uint64_t)count * total ) {
+        io.poll();
+        for ( int i = 0; i < count; ++i ) {
+            uint16_t before = lanes[i].out->count();
+            lanes[i].pipeline->processAll();
+            received += lanes[i].out->count() - before;
+        }
+    }
+    //let the last writes finish
+    while ( StatusCode::OK == io.poll() ) {
+    }
+    double s = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    *pSyscalls = io.getSyscalls();
+    closeLanes( lanes, count );
+    return received / s / 1e6;
+}
+
+int main( int argc, char** argv ) {
+    int      count  = ( argc > 1 ) ? atoi( argv[1] ) : 64;
+    uint32_t total  = ( ( argc > 2 ) ? atoi( argv[2] ) : 4 ) * 1000000u;
+    bool     pipes  = ( argc > 3 ) && !strcmp( argv[3], "pipe" );
+    if ( count < 1 || count > 256 ) {
+        count = 64;
+    }
+    nullFd = open( "/dev/null", O_WRONLY );
+    memset( chunk, 0x55, sizeof( chunk ) );
+
+    uint64_t a, b;
+    double rw = readWrite( count, total, pipes, &a );
+    double ur = uring( count, total, pipes, &b );
+    double mb = (double)count * total / 1e6;
+    printf( "%d %s, %u MB each\r\n", count, pipes ? "pipes" : "socketpairs", total / 1000000u );
+    printf( "read/write  %8.1f MB/s  %8.1f syscalls/MB\r\n", rw, a / mb );
+    printf( "io_uring    %8.1f MB/s  %8.1f syscalls/MB\r\n", ur, b / mb );
+    close( nullFd );
+    return 0;
+}
@@ -0,0 +1,371 @@
+/**
+ * @file    ggLibBench.cpp
+ *
+ * @brief   Microbenchmarks of the ggLib hot paths: ns/op, bytes/s and
+ *          heap allocations/op, optionally written as JSON to compare commits
+ *
+ * @note    This example code is free software: you can redistribute it and/or modify it.
+ *
+ *          This program is provided by EDI on an "AS IS" basis without
+ *          any warranties in the hope that it will be useful.
+ *
+ *          g++ -std=c++17 -O2 -I.. ggLibBench.cpp ../ByteArray.cpp ../CircularBuffer.cpp
+ *              ../Dictionary.cpp ../CommandTables.cpp ../Pipeline.cpp ../PipelineTrace.cpp
+ *              ../Pipe.cpp ../BufferPool.cpp -o ggLibBench
+ *          ./ggLibBench [filter] [--json results.json] [--scale n]
+ *
+ *          python3 -c "import json,sys; a,b=(json.load(open(f)) for f in sys.argv[1:]);
+ *              [print(r['name'], r['ns_per_op'], b[i]['ns_per_op']) for i,r in enumerate(a)]"
+ *              before.json after.json
+ *
+ * Gatis Gaigals, 2024
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "../ByteArray.h"
+#include "../CircularBuffer.h"
+#include "../Dictionary.h"
+#include "../aMap.h"
+#include "../CommandTables.h"
+#include "../Pipeline.h"
+
+
+/* Allocation counting */
+
+static uint64_t allocations = 0;
+
+void* operator new( size_t size ) {
+    ++allocations;
+    void* p = malloc( size ? size : 1 );
+    if ( !p ) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[]( size_t size ) {
+    return operator new( size );
+}
+
+void operator delete( void* p ) noexcept {
+    free( p );
+}
+
+void operator delete[]( void* p ) noexcept {
+    free( p );
+}
+
+void operator delete( void* p, size_t ) noexcept {
+    free( p );
+}
+
+void operator delete[]( void* p, size_t ) noexcept {
+    free( p );
+}
+
+
+/* Harness */
+
+struct Result {
+    std::string name;
+    uint64_t    ops;
+    double      nsPerOp;
+    double      bytesPerSecond;         //0 if the benchmark moves no payload
+    double      allocsPerOp;
+};
+
+static std::vector<Result>  results;
+static const char*          filter = nullptr;
+static uint32_t             scale  = 1;
+
+//keeps results alive without the compiler seeing through them
+static volatile uint64_t    sink;
+
+//body( n ) does n operations and moves n * bytesPerOp bytes
+template <typename Body>
+static void bench( const char* name, uint64_t ops, uint32_t bytesPerOp, Body body ) {
+    if ( filter && !strstr( name, filter ) ) {
+        return;
+    }
+    ops *= scale;
+    body( ops / 16 + 1 );               //warm up caches and lazily made state
+
+    uint64_t allocated = allocations;
+    auto t0 = std::chrono::steady_clock::now();
+    body( ops );
+    double s = std::chrono::duration<double>( std::chrono::steady_clock::now() - t0 ).count();
+    allocated = allocations - allocated;
+
+    Result result = { name, ops, s * 1e9 / ops,
+                      bytesPerOp ? (double)ops * bytesPerOp / s : 0.0,
+                      (double)allocated / ops };
+    printf( "%-32s %10.2f ns/op %10.1f MB/s %8.2f allocs/op\r\n",
+            name, result.nsPerOp, result.bytesPerSecond / 1e6, result.allocsPerOp );
+    results.push_back( result );
+}
+
+static bool writeJson( const char* path ) {
+    FILE* file = fopen( path, "w" );
+    if ( !file ) {
+        return false;
+    }
+    fprintf( file, "[" );
+    for ( size_t i = 0; i < results.size(); ++i ) {
+        const Result& r = results[i];
+        fprintf( file, "%s\n{\"name\":\"%s\",\"ops\":%llu,\"ns_per_op\":%.3f,"
+                       "\"bytes_per_s\":%.0f,\"allocs_per_op\":%.3f}",
+                 i ? "," : "", r.name.c_str(), (unsigned long long)r.ops,
+                 r.nsPerOp, r.bytesPerSecond, r.allocsPerOp );
+    }
+    fprintf( file, "\n]\n" );
+    return 0 == fclose( file );
+}
+
+
+/* ByteArray */
+
+static void byteArrayBenches( void ) {
+    bench( "ByteArray::append", 2000000, 1, []( uint64_t n ) {
+        ByteArray array( (uint16_t)1024 );
+        for ( uint64_t i = 0; i < n; ++i ) {
+            if ( array.count() == array.size() ) {
+                array.clear();
+            }
+            array.append( (uint8_t)i );
+        }
+        sink = array.count();
+    } );
+
+    bench( "ByteArray::mid 64", 1000000, 64, []( uint64_t n ) {
+        ByteArray array( (uint16_t)1024, 'x' );
+        uint64_t sum = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            sum += array.mid( i & 511, 64 ).count();
+        }
+        sink = sum;
+    } );
+
+    bench( "ByteArray copy 1024", 1000000, 1024, []( uint64_t n ) {
+        ByteArray array( (uint16_t)1024, 'x' );
+        uint64_t sum = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            ByteArray copy( array );
+            sum += copy.count();
+        }
+        sink = sum;
+    } );
+}
+
+
+/* CircularBuffer */
+
+static void circularBufferBenches( void ) {
+    bench( "CircularBuffer::put+get", 1000000, 1, []( uint64_t n ) {
+        CircularBuffer buffer( 256 );
+        uint64_t sum = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            buffer.put( (uint8_t)i );
+            sum += buffer.get();
+        }
+        sink = sum;
+    } );
+
+    bench( "CircularBuffer::at", 10000000, 1, []( uint64_t n ) {
+        CircularBuffer buffer( 256 );
+        for ( int i = 0; i < 200; ++i ) {
+            buffer.put( (uint8_t)i );
+        }
+        uint64_t sum = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            sum += buffer.at( (uint16_t)( i % 200 ) );
+        }
+        sink = sum;
+    } );
+}
+
+
+/* Dictionary */
+
+static const char* const dictionaryKeys[] = {
+    "id", "name", "version", "serial", "mode", "rate", "gain", "offset"
+};
+
+static void dictionaryBenches( void ) {
+    bench( "Dictionary::append 8 keys", 200000, 0, []( uint64_t n ) {
+        Dictionary dictionary( 256 );
+        for ( uint64_t i = 0; i < n; ++i ) {
+            dictionary.clear();
+            for ( auto key : dictionaryKeys ) {
+                dictionary.append( key, "value" );
+            }
+        }
+        sink = dictionary.count();
+    } );
+
+    Dictionary dictionary( 256 );
+    for ( auto key : dictionaryKeys ) {
+        dictionary.append( key, "value" );
+    }
+
+    bench( "Dictionary::contains", 2000000, 0, [&dictionary]( uint64_t n ) {
+        uint64_t hits = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            hits += ( nullptr != dictionary.contains( dictionaryKeys[i & 7] ) );
+        }
+        sink = hits;
+    } );
+
+    bench( "Dictionary::key(n)", 2000000, 0, [&dictionary]( uint64_t n ) {
+        uint64_t sum = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            sum += *dictionary.key( i & 7 );
+        }
+        sink = sum;
+    } );
+}
+
+
+/* aMap and findItem */
+
+static void nothing( void ) {
+}
+
+static const Command_t commands[] = {
+    { 'a', "a", nothing }, { 'b', "b", nothing }, { 'c', "c", nothing }, { 'd', "d", nothing },
+    { 'e', "e", nothing }, { 'f', "f", nothing }, { 'g', "g", nothing }, { 'h', "h", nothing },
+    { 'i', "i", nothing }, { 'j', "j", nothing }, { 'k', "k", nothing }, { 'l', "l", nothing },
+    { 'm', "m", nothing }, { 'n', "n", nothing }, { 'o', "o", nothing }, {  27, "quit", nothing }
+};
+
+static void lookupBenches( void ) {
+    aMap<uint8_t, int> map( {} );
+    for ( int i = 0; i < 16; ++i ) {
+        map.insert( commands[i].aKey, i );
+    }
+    bench( "aMap<uint8_t,int>::value", 5000000, 0, [&map]( uint64_t n ) {
+        uint64_t sum = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            sum += map.value( commands[i & 15].aKey, -1 );
+        }
+        sink = sum;
+    } );
+
+    bench( "findItem 16", 5000000, 0, []( uint64_t n ) {
+        uint64_t sum = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            sum += findItem( commands, 16, commands[i & 15].aKey );
+        }
+        sink = sum;
+    } );
+}
+
+
+/* Pipeline */
+
+//synthetic stage: moves everything that fits to the output, light work per byte
+static StatusCode work( ByteArray* pIn, ByteArray* pOut ) {
+    uint16_t n = pIn->count();
+    uint16_t space = pOut->size() - pOut->count();
+    if ( n > space ) {
+        n = space;
+    }
+    if ( 0 == n ) {
+        return pIn->count() ? StatusCode::OK : StatusCode::PENDING;
+    }
+    uint8_t* src = pIn->data();
+    uint8_t* dst = pOut->data() + pOut->count();
+    for ( uint16_t i = 0; i < n; ++i ) {
+        dst[i] = src[i] ^ 0x5A;
+    }
+    std::memmove( src, src + n, pIn->count() - n );
+    pIn->update_count( pIn->count() - n );
+    pOut->update_count( pOut->count() + n );
+    return StatusCode::NEXT;
+}
+
+//one processAll() pass pushing `chunk` bytes through `stages` stages
+static void pipelineBench( const char* name, uint8_t stages, uint16_t chunk ) {
+    bench( name, 200000, chunk, [stages, chunk]( uint64_t n ) {
+        ByteArray* buffers[9];
+        Pipeline pipeline( (uint16_t)0 );
+        for ( uint8_t i = 0; i <= stages; ++i ) {
+            buffers[i] = new ByteArray( (uint16_t)1024 );
+        }
+        for ( uint8_t i = 0; i < stages; ++i ) {
+            pipeline.AddProcessor( buffers[i], work, buffers[i + 1] );
+        }
+        uint64_t received = 0;
+        for ( uint64_t i = 0; i < n; ++i ) {
+            memset( buffers[0]->data(), (uint8_t)i, chunk );
+            buffers[0]->update_count( chunk );
+            pipeline.processAll();
+            received += buffers[stages]->count();
+            buffers[stages]->clear();
+        }
+        sink = received;
+        for ( uint8_t i = 0; i <= stages; ++i ) {
+            delete buffers[i];
+        }
+    } );
+}
+
+static StatusCode drop( ByteArray* pIn, ByteArray* ) {
+    pIn->clear();
+    return StatusCode::NEXT;
+}
+
+static void pipelineBenches( void ) {
+    bench( "Pipeline::Sink 256", 1000000, 256, []( uint64_t n ) {
+        uint8_t chunk[256] = { 1 };
+        ByteArray in( (uint16_t)1024 ), out( (uint16_t)16 );
+        Pipeline pipeline( (uint16_t)0 );
+        pipeline.AddProcessor( &in, drop, &out );
+        for ( uint64_t i = 0; i < n; ++i ) {
+            if ( StatusCode::OK != pipeline.Sink( 1, chunk, sizeof( chunk ) ) ) {
+                in.clear();
+            }
+        }
+        sink = in.count();
+    } );
+
+    pipelineBench( "Pipeline::processAll 1x64",  1, 64 );
+    pipelineBench( "Pipeline::processAll 4x64",  4, 64 );
+    pipelineBench( "Pipeline::processAll 8x64",  8, 64 );
+    pipelineBench( "Pipeline::processAll 4x512", 4, 512 );
+}
+
+
+int main( int argc, char** argv ) {
+    const char* json = nullptr;
+    for ( int i = 1; i < argc; ++i ) {
+        if ( !strcmp( argv[i], "--json" ) && i + 1 < argc ) {
+            json = argv[++i];
+        } else if ( !strcmp( argv[i], "--scale" ) && i + 1 < argc ) {
+            scale = atoi( argv[++i] );
+            if ( !scale ) {
+                scale = 1;
+            }
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    byteArrayBenches();
+    circularBufferBenches();
+    dictionaryBenches();
+    lookupBenches();
+    pipelineBenches();
+
+    if ( json && !writeJson( json ) ) {
+        printf( "could not write %s\r\n", json );
+        return 1;
+    }
+    return 0;
+}